@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "cgroup-stats.h"
+
+static const char *cgroup_file[CGROUP_FILE_CNT] = {
+	"memory.current", "memory.stat", "memory.swap.current", "cpu.stat", "cgroup.procs"
+};
+
+// Sluit de directory en de files, bv. omdat de cgroup verdwenen is.
+static void cgroup_close(cgroup_t *cg) {
+	for (int i=0; i<CGROUP_FILE_CNT; i++) {
+		if (cg->fd[i] != -1)
+			close(cg->fd[i]);
+		cg->fd[i] = -1;
+	}
+	if (cg->dir_fd != -1)
+		close(cg->dir_fd);
+	cg->dir_fd = -1;
+}
+
+// Open de directory en de files.  Een service die herstart wordt krijgt een nieuwe cgroup
+// met dezelfde naam; de oude files leveren dan een fout op en worden opnieuw geopend.
+static int cgroup_open(cgroup_t *cg) {
+	if ((cg->dir_fd = open(cg->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1)
+		return -1;
+	for (int i=0; i<CGROUP_FILE_CNT; i++)
+		cg->fd[i] = openat(cg->dir_fd, cgroup_file[i], O_RDONLY | O_CLOEXEC);
+	return 0;
+}
+
+// <name> is het pad onder /sys/fs/cgroup/ (bv. system.slice/nginx.service, zoals in
+// /proc/PID/cgroup, met of zonder '/' vooraan), of een volledig pad daaronder.
+// CGROUP_ROOT vervangt /sys/fs/cgroup/ (bv. voor tests).
+cgroup_t * cgroup_create(const char *name) {
+	const char *root = getenv("CGROUP_ROOT") ? : "/sys/fs/cgroup/";
+	cgroup_t *cg;
+
+	if ((cg = calloc(1, sizeof(cgroup_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(cgroup_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if (strncmp(name, root, strlen(root)) == 0)
+		snprintf(cg->path, sizeof(cg->path), "%s", name);
+	else
+		snprintf(cg->path, sizeof(cg->path), "%s%s", root, name + (name[0] == '/'));
+	cg->dir_fd = -1;
+	for (int i=0; i<CGROUP_FILE_CNT; i++)
+		cg->fd[i] = -1;
+	if (cgroup_open(cg) == -1) {
+		printf("ERROR - failed to open cgroup %s, %d - %s\n", cg->path, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return cg;
+}
+
+void cgroup_destroy(cgroup_t *cg) {
+	cgroup_close(cg);
+	free(cg);
+}
+
+// Lees een file opnieuw vanaf het begin.  Geeft de lengte terug, of -1.
+static ssize_t cgroup_pread(cgroup_t *cg, int i) {
+	ssize_t len;
+
+	if (cg->fd[i] == -1)
+		return -1;
+	if ((len = pread(cg->fd[i], cg->buf, sizeof(cg->buf) - 1, 0)) < 0)
+		return -1;
+	cg->buf[len] = '\0';
+	return len;
+}
+
+// Tel de regels (PID's) van cgroup.procs.  Die file kan groter zijn dan de buffer, dus hij
+// wordt in stukken gelezen.  Geeft -1 terug bij een leesfout.
+static long cgroup_count_procs(cgroup_t *cg) {
+	off_t off = 0;
+	ssize_t len;
+	long cnt = 0;
+	char *p, *end;
+
+	while ((len = pread(cg->fd[CGROUP_PROCS], cg->buf, sizeof(cg->buf), off)) > 0) {
+		for (p=cg->buf, end=cg->buf + len; (p = memchr(p, '\n', end - p)) != NULL; p++)
+			cnt++;
+		off += len;
+	}
+	return len < 0 ? -1 : cnt;
+}
+
+// Vergelijk de sleutel van een regel (tot de spatie) met een vaste naam.
+#define KEY_IS(p, n, name) ((n) == sizeof(name) - 1 && memcmp((p), (name), sizeof(name) - 1) == 0)
+
+// Lees de files van de cgroup.  Geeft 0 terug en vult s, of -1 wanneer de cgroup niet
+// (meer) bestaat; s is dan 0.
+int cgroup_read(cgroup_t *cg, cgroup_sample_t *s) {
+	unsigned long long val;
+	char *p, *end, *sp, *nl;
+	ssize_t len;
+	size_t n;
+
+	memset(s, 0, sizeof(cgroup_sample_t));
+	if (cg->dir_fd == -1 && cgroup_open(cg) == -1) {
+		cg->fail_cnt++;
+		return -1;
+	}
+
+	// Alle files bestaan zolang de cgroup bestaat; een verwijderde cgroup geeft ENODEV.
+	for (int i=0; i<CGROUP_FILE_CNT; i++) {
+		if (i == CGROUP_PROCS && cg->fd[i] != -1) {
+			if ((s->procs = cgroup_count_procs(cg)) != -1)
+				continue;
+			len = -1;
+		} else {
+			len = cgroup_pread(cg, i);
+		}
+		if (len == -1) {
+			if (cg->fd[i] != -1) {
+				cgroup_close(cg);
+				cg->fail_cnt++;
+				memset(s, 0, sizeof(cgroup_sample_t));
+				return -1;
+			}
+			continue;
+		}
+		// memory.current en memory.swap.current bevatten één getal.
+		if (i != CGROUP_MEMORY_STAT && i != CGROUP_CPU_STAT) {
+			for (val=0, p=cg->buf; *p >= '0' && *p <= '9'; p++)
+				val = val * 10 + (*p - '0');
+			if (i == CGROUP_MEMORY_CURRENT)
+				s->mem_current = val / 1024;
+			else
+				s->swap = val / 1024;
+			continue;
+		}
+		// memory.stat en cpu.stat bevatten regels "<naam> <getal>".
+		end = cg->buf + len;
+		for (p=cg->buf; p < end; p=nl + 1) {
+			if ((nl = memchr(p, '\n', end - p)) == NULL)
+				nl = end;
+			if ((sp = memchr(p, ' ', nl - p)) == NULL)
+				continue;
+			n = sp - p;
+			for (val=0, sp++; *sp >= '0' && *sp <= '9'; sp++)
+				val = val * 10 + (*sp - '0');
+
+			if (i == CGROUP_MEMORY_STAT) {
+				if (KEY_IS(p, n, "anon"))
+					s->anon = val / 1024;
+				else if (KEY_IS(p, n, "file_mapped"))
+					s->file_mapped = val / 1024;
+				else if (KEY_IS(p, n, "anon_thp"))
+					s->anon_thp = val / 1024;
+			} else {
+				if (KEY_IS(p, n, "user_usec"))
+					s->user_usec = val;
+				else if (KEY_IS(p, n, "system_usec"))
+					s->system_usec = val;
+			}
+		}
+	}
+	cg->read_cnt++;
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define CGROUP_BUF_SIZE  8192           // memory.stat is ongeveer 1500 bytes
+#define CGROUP_PATH_LEN  4096
+
+#define CGROUP_MEMORY_CURRENT 0
+#define CGROUP_MEMORY_STAT    1
+#define CGROUP_MEMORY_SWAP    2
+#define CGROUP_CPU_STAT       3
+#define CGROUP_PROCS          4
+#define CGROUP_FILE_CNT       5
+
+// Metingen van één cgroup (v2) als geheel (optie -g), in KiB resp. microseconden.
+//
+// Onder systemd heeft elke service een eigen cgroup, en de kernel houdt daarin het verbruik
+// van alle processen van de service al bij.  In plaats van alle processen af te lopen en hun
+// RSS op te tellen (waarbij gedeelde pagina's meerdere keren meetellen) volstaan dan een paar
+// files per interval, en elke pagina is precies één keer aan één cgroup toegerekend.  De
+// tellers omvatten ook de sub-cgroups en lopen door na het stoppen van processen (cpu.stat).
+// Ontbreekt een file (bv. geen memory-controller voor deze cgroup), dan blijven de bijbehorende
+// velden 0.  Het aantal processen komt uit cgroup.procs en telt, anders dan pids.current, geen
+// threads: de kolom procs betekent zo hetzelfde als bij -c, en de trend-schatting van -L ziet
+// een groeiende thread-pool niet als een nieuw proces.  cgroup.procs bevat alleen de processen
+// van de cgroup zelf, niet die van de sub-cgroups.
+typedef struct cgroup_sample {
+	long procs;                        // aantal regels van cgroup.procs (processen, geen threads)
+	long mem_current;                  // memory.current: alles, inclusief page cache
+	long anon;                         // memory.stat anon
+	long file_mapped;                  // memory.stat file_mapped
+	long anon_thp;                     // memory.stat anon_thp (transparent huge pages)
+	long swap;                         // memory.swap.current
+	unsigned long long user_usec;      // cpu.stat user_usec
+	unsigned long long system_usec;    // cpu.stat system_usec
+} cgroup_sample_t;
+
+struct cgroup {
+	char path[CGROUP_PATH_LEN];        // volledige directory van de cgroup
+	int fd[CGROUP_FILE_CNT];           // de files blijven open; -1 = niet beschikbaar
+	int dir_fd;                        // -1 wanneer de cgroup (nog) niet bestaat
+	unsigned long read_cnt;            // aantal metingen sinds de start
+	unsigned long fail_cnt;            // aantal metingen waarin de cgroup niet bestond
+	char buf[CGROUP_BUF_SIZE];
+};
+
+typedef struct cgroup cgroup_t;
+
+cgroup_t * cgroup_create(const char *name);
+void cgroup_destroy(cgroup_t *cg);
+int  cgroup_read(cgroup_t *cg, cgroup_sample_t *s);
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Hash-aggregaat van de procesnamen voor de optie -A (open addressing, lineair zoeken,
+ * FNV-1a zoals de naam-cache van cmd-match.c).  Het aantal verschillende procesnamen op
+ * een systeem is klein, dus de tabel groeit alleen in de eerste intervallen.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmd-group.h"
+
+static cmd_group_slot_t * cmd_group_alloc(size_t size) {
+	cmd_group_slot_t *slot;
+
+	if ((slot = malloc(size * sizeof(cmd_group_slot_t))) == NULL) {
+		printf("ERROR - malloc(%ld) failed, %d - %s\n", size * sizeof(cmd_group_slot_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	for (size_t i=0; i<size; i++)
+		slot[i].idx = -1;
+	return slot;
+}
+
+static void cmd_group_grow(cmd_group_tab_t *tab) {
+	cmd_group_slot_t *old = tab->slot;
+	size_t old_size = tab->size;
+	size_t mask, i, k;
+
+	tab->size *= 2;
+	tab->slot = cmd_group_alloc(tab->size);
+	mask = tab->size - 1;
+	for (k=0; k<old_size; k++) {
+		if (old[k].idx == -1)
+			continue;
+		for (i = old[k].hash & mask; tab->slot[i].idx != -1; i = (i + 1) & mask)
+			;
+		tab->slot[i] = old[k];
+	}
+	free(old);
+}
+
+cmd_group_tab_t * cmd_group_create(void) {
+	cmd_group_tab_t *tab;
+
+	if ((tab = calloc(1, sizeof(cmd_group_tab_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(cmd_group_tab_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	tab->size = CMD_GROUP_INITIAL_SIZE;
+	tab->slot = cmd_group_alloc(tab->size);
+	return tab;
+}
+
+void cmd_group_destroy(cmd_group_tab_t *tab) {
+	free(tab->slot);
+	free(tab);
+}
+
+// Geef het volgnummer van de groep van procesnaam <name>.  Een nieuwe naam krijgt het
+// volgende vrije volgnummer (tab->cnt - 1 na de aanroep).
+int cmd_group_find(cmd_group_tab_t *tab, const char *name) {
+	unsigned int h = 2166136261u;   // FNV-1a
+	cmd_group_slot_t *s;
+	size_t len, mask, i;
+
+	for (len = 0; name[len] && len < CMD_GROUP_NAME_LEN - 1; len++) {
+		h ^= (unsigned char) name[len];
+		h *= 16777619u;
+	}
+
+	mask = tab->size - 1;
+	for (i = h & mask; tab->slot[i].idx != -1; i = (i + 1) & mask) {
+		s = &tab->slot[i];
+		if (s->hash == h && strncmp(s->name, name, len) == 0 && s->name[len] == '\0')
+			return s->idx;
+	}
+
+	// Nieuwe naam.  Houd de tabel hooguit half vol.
+	if ((size_t) (tab->cnt + 1) * 2 > tab->size) {
+		cmd_group_grow(tab);
+		mask = tab->size - 1;
+		for (i = h & mask; tab->slot[i].idx != -1; i = (i + 1) & mask)
+			;
+	}
+	s = &tab->slot[i];
+	memcpy(s->name, name, len);
+	s->name[len] = '\0';
+	s->hash = h;
+	s->idx  = tab->cnt++;
+	return s->idx;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define CMD_GROUP_NAME_LEN     16      // procesnamen (comm) zijn maximaal 15 tekens
+#define CMD_GROUP_INITIAL_SIZE 1024    // aantal slots, altijd een macht van 2
+
+// Hash-aggregaat voor de optie -A: elke procesnaam (comm) krijgt bij de eerste keer dat hij
+// gezien wordt een vast volgnummer.  De naam wordt maar één keer opgeslagen; de aanroeper
+// houdt zijn tellingen per groep bij in een array op dat volgnummer, die daardoor van interval
+// tot interval dezelfde groep bevat (nodig voor de delta's).
+typedef struct cmd_group_slot {
+	char name[CMD_GROUP_NAME_LEN];
+	unsigned int hash;
+	int idx;                           // volgnummer van de groep, -1 = vrij slot
+} cmd_group_slot_t;
+
+struct cmd_group_tab {
+	cmd_group_slot_t *slot;
+	size_t size;                       // aantal slots, altijd een macht van 2
+	int cnt;                           // aantal groepen
+};
+
+typedef struct cmd_group_tab cmd_group_tab_t;
+
+cmd_group_tab_t * cmd_group_create(void);
+void cmd_group_destroy(cmd_group_tab_t *tab);
+int  cmd_group_find(cmd_group_tab_t *tab, const char *name);
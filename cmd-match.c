@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Gecompileerde matcher voor de filteropties -c en -u.
+ *
+ * Alle patterns (-c) worden in een prefix-trie opgenomen.  Een procesnaam matcht
+ * een pattern wanneer de naam met dat pattern begint; één walk door de trie levert
+ * alle matchende patterns op, ongeacht het aantal opgegeven patterns.
+ * Het resultaat wordt per exacte procesnaam bewaard in een hash-set.  Omdat het aantal
+ * verschillende procesnamen op een systeem klein is, wordt de trie na het eerste
+ * interval vrijwel nooit meer doorlopen.
+ *
+ * De uid's (-u, ook ranges) worden in een bitmap bijgehouden, zodat een uid-check O(1) is.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmd-match.h"
+
+static void * cmd_matcher_realloc(void *ptr, size_t size) {
+	void *p;
+
+	if ((p = realloc(ptr, size)) == NULL) {
+		printf("ERROR - realloc(%ld) failed, %d - %s\n", size, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+static int cmd_trie_new_node(cmd_matcher_t *m, char c) {
+	if (m->node_cnt == m->node_cap) {
+		m->node_cap = m->node_cap ? m->node_cap * 2 : 64;
+		m->node = cmd_matcher_realloc(m->node, m->node_cap * sizeof(struct cmd_trie_node));
+	}
+	m->node[m->node_cnt].first_child  = -1;
+	m->node[m->node_cnt].next_sibling = -1;
+	m->node[m->node_cnt].pattern      = -1;
+	m->node[m->node_cnt].c            = c;
+	return m->node_cnt++;
+}
+
+static void cmd_names_alloc(cmd_matcher_t *m, size_t size) {
+	if ((m->name = calloc(size, sizeof(struct cmd_name_ent))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", size * sizeof(struct cmd_name_ent), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	m->name_size = size;
+	m->name_used = 0;
+}
+
+// Leeg de hash-set van procesnamen (bij nieuwe patterns, of wanneer hij te groot wordt).
+static void cmd_names_clear(cmd_matcher_t *m) {
+	memset(m->name, 0, m->name_size * sizeof(struct cmd_name_ent));
+	m->name_used    = 0;
+	m->name_idx_cnt = 0;
+}
+
+static void cmd_names_grow(cmd_matcher_t *m) {
+	struct cmd_name_ent *old = m->name;
+	size_t old_size = m->name_size;
+	size_t mask, i, k;
+
+	cmd_names_alloc(m, old_size * 2);
+	mask = m->name_size - 1;
+	for (k=0; k<old_size; k++) {
+		if (!old[k].used)
+			continue;
+		for (i = old[k].hash & mask; m->name[i].used; i = (i + 1) & mask)
+			;
+		m->name[i] = old[k];
+		m->name_used++;
+	}
+	free(old);
+}
+
+cmd_matcher_t * cmd_matcher_create(void) {
+	cmd_matcher_t *m;
+
+	if ((m = calloc(1, sizeof(cmd_matcher_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(cmd_matcher_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	cmd_trie_new_node(m, '\0');              // root
+	cmd_names_alloc(m, CMD_MATCH_NAMES_INITIAL);
+	return m;
+}
+
+void cmd_matcher_destroy(cmd_matcher_t *m) {
+	for (int i=0; i<m->pattern_cnt; i++)
+		free(m->pattern[i]);
+	free(m->pattern);
+	free(m->pattern_next);
+	free(m->node);
+	free(m->name);
+	free(m->name_idx);
+	free(m->uid_bitmap);
+	free(m->uid_range);
+	free(m);
+}
+
+// Voeg een pattern toe aan de trie en geef het volgnummer van het pattern terug.
+int cmd_matcher_add_cmd(cmd_matcher_t *m, const char *pattern) {
+	int cur = 0, child;
+	const char *c;
+
+	if (m->pattern_cnt == m->pattern_cap) {
+		m->pattern_cap  = m->pattern_cap ? m->pattern_cap * 2 : 16;
+		m->pattern      = cmd_matcher_realloc(m->pattern,      m->pattern_cap * sizeof(char *));
+		m->pattern_next = cmd_matcher_realloc(m->pattern_next, m->pattern_cap * sizeof(int));
+	}
+	m->pattern[m->pattern_cnt] = strndup(pattern, CMD_MATCH_NAME_LEN - 1);
+
+	for (c = m->pattern[m->pattern_cnt]; *c; c++) {
+		for (child = m->node[cur].first_child; child != -1; child = m->node[child].next_sibling) {
+			if (m->node[child].c == *c)
+				break;
+		}
+		if (child == -1) {
+			child = cmd_trie_new_node(m, *c);
+			m->node[child].next_sibling = m->node[cur].first_child;
+			m->node[cur].first_child    = child;
+		}
+		cur = child;
+	}
+	m->pattern_next[m->pattern_cnt] = m->node[cur].pattern;
+	m->node[cur].pattern            = m->pattern_cnt;
+
+	// Eerder bewaarde resultaten kennen het nieuwe pattern nog niet.
+	cmd_names_clear(m);
+	return m->pattern_cnt++;
+}
+
+void cmd_matcher_add_uid(cmd_matcher_t *m, unsigned int lo, unsigned int hi) {
+	unsigned int uid;
+
+	if (!m->uid_bitmap) {
+		if ((m->uid_bitmap = calloc(CMD_MATCH_UID_BITMAP / 8, 1)) == NULL) {
+			printf("ERROR - calloc(%d) failed, %d - %s\n", CMD_MATCH_UID_BITMAP / 8, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (uid = lo; uid <= hi && uid < CMD_MATCH_UID_BITMAP; uid++)
+		m->uid_bitmap[uid >> 3] |= 1 << (uid & 7);
+	if (hi >= CMD_MATCH_UID_BITMAP) {
+		// Het deel boven de bitmap komt in de (korte) lijst met ranges.
+		if (m->uid_range_cnt == m->uid_range_cap) {
+			m->uid_range_cap = m->uid_range_cap ? m->uid_range_cap * 2 : 4;
+			m->uid_range = cmd_matcher_realloc(m->uid_range, m->uid_range_cap * sizeof(struct uid_range));
+		}
+		m->uid_range[m->uid_range_cnt].lo = lo > CMD_MATCH_UID_BITMAP ? lo : CMD_MATCH_UID_BITMAP;
+		m->uid_range[m->uid_range_cnt].hi = hi;
+		m->uid_range_cnt++;
+	}
+	m->uid_cnt++;
+}
+
+int cmd_matcher_uid(cmd_matcher_t *m, unsigned int uid) {
+	if (!m->uid_bitmap)
+		return 0;
+	if (uid < CMD_MATCH_UID_BITMAP)
+		return (m->uid_bitmap[uid >> 3] >> (uid & 7)) & 1;
+	for (int i=0; i<m->uid_range_cnt; i++) {
+		if (uid >= m->uid_range[i].lo && uid <= m->uid_range[i].hi)
+			return 1;
+	}
+	return 0;
+}
+
+// Zoek alle patterns die op de procesnaam matchen.  Geeft het aantal matches terug;
+// *idx wijst naar de volgnummers van de matchende patterns.  Die pointer blijft
+// geldig tot de volgende aanroep van cmd_matcher_find().
+int cmd_matcher_find(cmd_matcher_t *m, const char *name, const int **idx) {
+	struct cmd_name_ent *e;
+	unsigned int h = 2166136261u;   // FNV-1a
+	size_t len, mask, i;
+	int cur, child, p;
+
+	for (len = 0; name[len] && len < CMD_MATCH_NAME_LEN - 1; len++) {
+		h ^= (unsigned char) name[len];
+		h *= 16777619u;
+	}
+
+	// Hebben we deze naam al eens gezien?
+	mask = m->name_size - 1;
+	for (i = h & mask; m->name[i].used; i = (i + 1) & mask) {
+		e = &m->name[i];
+		if (e->hash == h && strncmp(e->name, name, len) == 0 && e->name[len] == '\0') {
+			*idx = m->name_idx + e->first;
+			return e->cnt;
+		}
+	}
+
+	// Nieuwe naam: maak ruimte in de hash-set en loop de trie door.
+	if (m->name_used >= CMD_MATCH_NAMES_MAX) {
+		cmd_names_clear(m);
+	} else if ((m->name_used + 1) * 2 > m->name_size) {
+		cmd_names_grow(m);
+	}
+	mask = m->name_size - 1;
+	for (i = h & mask; m->name[i].used; i = (i + 1) & mask)
+		;
+	e = &m->name[i];
+	memcpy(e->name, name, len);
+	e->name[len] = '\0';
+	e->hash  = h;
+	e->first = m->name_idx_cnt;
+	e->cnt   = 0;
+	e->used  = 1;
+	m->name_used++;
+
+	cur = 0;
+	for (size_t k = 0; ; k++) {
+		for (p = m->node[cur].pattern; p != -1; p = m->pattern_next[p]) {
+			if (m->name_idx_cnt == m->name_idx_cap) {
+				m->name_idx_cap = m->name_idx_cap ? m->name_idx_cap * 2 : 256;
+				m->name_idx = cmd_matcher_realloc(m->name_idx, m->name_idx_cap * sizeof(int));
+			}
+			m->name_idx[m->name_idx_cnt++] = p;
+			e->cnt++;
+		}
+		if (k == len)
+			break;
+		for (child = m->node[cur].first_child; child != -1; child = m->node[child].next_sibling) {
+			if (m->node[child].c == name[k])
+				break;
+		}
+		if (child == -1)
+			break;
+		cur = child;
+	}
+	*idx = m->name_idx + e->first;
+	return e->cnt;
+}
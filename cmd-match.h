@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define CMD_MATCH_NAME_LEN   (64+1)
+#define CMD_MATCH_NAMES_INITIAL 1024
+#define CMD_MATCH_NAMES_MAX  65536         // daarboven wordt de hash-set geleegd (bv. veel kworker-namen)
+#define CMD_MATCH_UID_BITMAP 65536         // uid's kleiner dan deze waarde staan in de bitmap
+
+// Node van de prefix-trie.  De nodes staan in één array en verwijzen naar elkaar via indexen,
+// zodat de array kan groeien zonder dat er pointers gefixt hoeven te worden.
+struct cmd_trie_node {
+        int  first_child;              // -1 = geen kinderen
+        int  next_sibling;             // -1 = laatste kind
+        int  pattern;                  // eerste pattern dat op deze node eindigt, -1 = geen
+        char c;
+};
+
+// Entry in de hash-set van exacte procesnamen.  Per naam die we ooit gezien hebben
+// bewaren we de lijst van patterns die erop matchen, zodat de trie per naam maar
+// één keer doorlopen hoeft te worden.
+struct cmd_name_ent {
+        char          name[CMD_MATCH_NAME_LEN];
+        unsigned int  hash;
+        int           first;           // index in name_idx[] van de eerste match
+        int           cnt;             // aantal matches (0 = deze naam matcht niets)
+        unsigned char used;
+};
+
+struct uid_range {
+        unsigned int lo;
+        unsigned int hi;
+};
+
+struct cmd_matcher {
+        // patterns (-c), in de volgorde waarin ze zijn opgegeven
+        char                 **pattern;
+        int                   *pattern_next;    // volgende pattern dat op dezelfde trie-node eindigt
+        int                    pattern_cnt;
+        int                    pattern_cap;
+        // prefix-trie over alle patterns
+        struct cmd_trie_node  *node;
+        int                    node_cnt;
+        int                    node_cap;
+        // hash-set van exacte procesnamen met hun match-resultaat
+        struct cmd_name_ent   *name;
+        size_t                 name_size;       // altijd een macht van 2
+        size_t                 name_used;
+        int                   *name_idx;
+        size_t                 name_idx_cnt;
+        size_t                 name_idx_cap;
+        // uid's (-u): een bitmap voor de lage uid's en een lijst van ranges voor de rest
+        unsigned char         *uid_bitmap;
+        struct uid_range      *uid_range;
+        int                    uid_range_cnt;
+        int                    uid_range_cap;
+        int                    uid_cnt;         // aantal opgegeven uid's of uid-ranges
+};
+
+typedef struct cmd_matcher cmd_matcher_t;
+
+cmd_matcher_t * cmd_matcher_create(void);
+void cmd_matcher_destroy(cmd_matcher_t *m);
+int  cmd_matcher_add_cmd(cmd_matcher_t *m, const char *pattern);
+void cmd_matcher_add_uid(cmd_matcher_t *m, unsigned int lo, unsigned int hi);
+int  cmd_matcher_find(cmd_matcher_t *m, const char *name, const int **idx);
+int  cmd_matcher_uid(cmd_matcher_t *m, unsigned int uid);
@@ -32,7 +32,7 @@
  *     - VSZ (in gebruik zijnd virtueel geheugen)
  *     - RSS (in gebruik zijnd fysiek geheugen)
  *     - CPU (aparte metingen voor user- en system-cycles)
- *     - TCP-sockets (optioneel via de optie -s)
+ *     - sockets: TCP, UDP (IPv4 en IPv6) en UNIX (optioneel via de optie -s)
  *
  * De metingen worden alleen uitgevoerd in delta-mode (-d).
  * In delta-mode dien je de processen te specificeren via de programmanaam (-c).
@@ -54,19 +54,35 @@
  */
 
 #include <time.h>
-#include <sys/time.h>  // voor setitimer()
 #include <errno.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <pwd.h>
 #include <features.h>
+#include <limits.h>
 #include <linux/limits.h>
 #include <libproc2/pids.h>
 #include "procps-pids.h"
 #include "mempool.h"
+#include "cmd-match.h"
+#include "cmd-group.h"
 #include "inode-stats.h"
+#include "proc-sample.h"
+#include "proc-extra.h"
+#include "pid-state.h"
+#include "proc-track.h"
+#include "proc-events.h"
+#include "ring-out.h"
+#include "out-fmt.h"
+#include "prom-http.h"
+#include "leak-trend.h"
+#include "smaps-stats.h"
+#include "cgroup-stats.h"
+#include "tick-loop.h"
+#include "self-stats.h"
 #include "cmd-metrics.h"
 
 // PROCTAB *proc;
@@ -83,30 +99,89 @@ void SIGHUP_handler(int sig) {
     shouldReopenStdout = true;
 }
 
-void SIGALRM_handler(int sig) {
-    // no-op
-}
 
 void print_syntax(long ticks_per_sec, long cpu_cnt, long pagesize, long physpages, long physpages_avail) {
-        fprintf(stderr, "syntax: $ cmd-metrics -d -c <cmd> [-c <cmd> ...] [-i <interval (s)>] [-r <repeat-header>] [-s]\n"
-                        "    or: $ cmd-metrics -u <uid> [-u <uid> ...]     (list processes running with a specific numeric uid)\n"
+        fprintf(stderr, "syntax: $ cmd-metrics -d -c <cmd> [-c <cmd> ...] [-g <cgroup> ...] [-i <interval (s)>] [-r <repeat-header>] [-D <n>] [-e] [-L <minutes>] [-m <file>] [-M <n>] [-o <format>] [-p] [-P <address>] [-s [-j <threads>]] [-T] [-x <classes>]\n"
+                        "    or: $ cmd-metrics -d -A [-n <top>] [-u <uid> ...] [-i <interval (s)>] [-r <repeat-header>] [-o <format>] [-T] [-x <classes>]\n"
+                        "    or: $ cmd-metrics -u <uid>[-<uid>] [-u ...]   (list processes running with a specific numeric uid)\n"
                         "    or: $ cmd-metrics -c <cmd> [-c <cmd> ...]     (list processes running with a specific command)\n"
                         "    or: $ cmd-metrics -u <uid> -a [-c <cmd> ...]  (list processes running with a specific uid AND command)\n"
-                        "    or: $ cmd-metrics [-t]                        (full list of processes, optionally including LWP's (threads))\n"
+                        "    or: $ cmd-metrics [-t] [-o <format>]          (full list of processes, optionally including LWP's (threads))\n"
                         "    or: $ cmd-metrics -h         (this help text)\n"
 	                "\n"
                         "Arguments:\n"
 			"        -a                 Switch the filter options (-c and -u) to AND mode.  (default mode is OR)\n"
 			"                           In the AND mode, proc-records are only listed if both cmd and uid match.\n"
+                        "        -A                 Group all processes (optionally filtered by -u) by command name instead of\n"
+                        "                           measuring the commands of -c, and show the top <n> groups (-n) by RSS growth\n"
+                        "                           over the interval, one line per group.  Meant for spotting leaks in services\n"
+                        "                           nobody thought of watching.  A command that was not running in the previous\n"
+                        "                           interval starts with a growth of 0.  Delta mode only; cannot be combined with\n"
+                        "                           -c, -D, -e, -g, -L, -m, -M, -p, -P or -s.\n"
                         "        -c <command>       Program name (executable) to filter on.\n"
-			"                           Multiple -c arguments are allowed.\n"
+			"                           Multiple -c arguments are allowed, there is no limit on their number.\n"
 			"                           When specifying only part of a command, it will match all processes\n"
 			"                           whose command name start with that string.\n"
                         "        -d                 Delta-mode.  In this mode the program calculates the allocation and\n"
 			"                           release of resources.  Those resources are VSZ, RSS, and (optionally) sockets.\n"
+                        "        -D <n>             Discover the processes to measure only every <n> intervals (default 1).\n"
+                        "                           In between, only /proc/PID/stat of the processes found at the last\n"
+                        "                           discovery is re-read, which is much cheaper on hosts with many processes.\n"
+                        "                           Processes started in between are picked up at the next discovery.\n"
+                        "                           This option is only available in delta mode.\n"
+                        "        -e                 Keep the set of measured processes up to date with process events from the\n"
+                        "                           kernel (proc connector, requires CAP_NET_ADMIN) instead of rescanning /proc:\n"
+                        "                           new processes are measured from the next interval on, and a full discovery\n"
+                        "                           is only done at the start, every -D intervals (default 300) as a check, and\n"
+                        "                           after the kernel dropped events.  Requires delta mode and an interval (-i).\n"
+                        "        -g <cgroup>        Add a column for a cgroup (v2), e.g. system.slice/nginx.service, next to the\n"
+                        "                           -c columns.  The figures come from the cgroup files instead of a walk over the\n"
+                        "                           processes: procs counts cgroup.procs (no threads), vsz is memory.current (all memory\n"
+                        "                           charged to the cgroup, including page cache), rss is anon + file_mapped from\n"
+                        "                           memory.stat, utime/stime come from cpu.stat, and with -M pss/anon/anon-huge/swap\n"
+                        "                           are filled from memory.stat and memory.swap.current.  Every page is charged to\n"
+                        "                           one cgroup only, so nothing is counted twice.  Sockets (-s), spawn/exit (-p)\n"
+                        "                           and uss stay 0.  Multiple -g arguments are allowed.  Delta mode only.\n"
 			"        -h                 This help text.\n"
-                        "        -i <interval>      Interval in seconds.\n"
+                        "        -i <interval>      Interval in seconds, fractions allowed (e.g. 0.25, at least 0.001).\n"
+                        "                           The samples are scheduled at fixed times, so they do not drift;\n"
+                        "                           an interval that is skipped because a sample took too long is reported\n"
+                        "                           on stderr (and counted with -T).\n"
+                        "        -j <threads>       Number of threads for the socket scan of option -s (default 1).\n"
+                        "                           The file descriptors of all matching processes are spread over the threads,\n"
+                        "                           so a few processes with many sockets still keep all threads busy.\n"
+                        "        -L <minutes>       Estimate the RSS trend of every command over a window of <minutes> and flag\n"
+                        "                           a suspected leak (column leak, plus a WARNING on stderr) when the RSS keeps\n"
+                        "                           growing by more than 1 MiB/h.  Columns: rss-MiB/h (exponentially weighted),\n"
+                        "                           win-MiB/h (sliding window) and t (confidence of the trend, higher is surer).\n"
+                        "                           Requires delta mode and an interval (-i).\n"
+                        "        -m <file>          Also write every sample as a fixed-size binary record into a memory-mapped\n"
+                        "                           ring file (the last 4096 samples), for local consumers such as dashboards.\n"
+                        "                           Readers never block the sampler; see ring-read.c and ring-out.h for the format.\n"
+                        "                           A restart replaces the file (readers keep the old one); ring-read -f follows it.\n"
+                        "                           This option is only available in delta mode.\n"
+                        "        -M <n>             Also read /proc/PID/smaps_rollup every <n> intervals and show the PSS, USS,\n"
+                        "                           anonymous memory, transparent huge pages and (proportional) swap per command.\n"
+                        "                           Unlike RSS, PSS does not count pages shared between processes more than once.\n"
+                        "                           The kernel walks the page tables to produce smaps_rollup, so it is expensive\n"
+                        "                           for large processes; see smaps-bench.c.  Delta mode only.\n"
+                        "        -n <top>           Number of groups shown with -A (default %d).\n"
+                        "        -o <format>        Output format: table (default), csv or json (JSON Lines, one object per line).\n"
+                        "                           In delta mode, csv and json give one record per command per interval,\n"
+                        "                           with the datetime and the command name as the first two fields.\n"
+                        "        -p                 Track every process individually and show the process churn per interval:\n"
+                        "                           CPU used during the interval (d-utime, d-stime), the number of processes\n"
+                        "                           started (spawn) and stopped (exit), and the RSS released by stopped processes.\n"
+                        "                           This option is only available in delta mode.\n"
+                        "        -P <address>       Serve the latest sample over HTTP in the Prometheus text format (GET /metrics).\n"
+                        "                           <address> is <port> (on 127.0.0.1), <host>:<port>, [<ipv6>]:<port>, or the\n"
+                        "                           path of a UNIX socket.  The response is rendered once per interval, so\n"
+                        "                           extra scrapers cost next to nothing.  Requires delta mode and an interval (-i).\n"
                         "        -s                 Provide some information on socket use.\n"
+			"                           TCP, UDP (both IPv4 and IPv6) and UNIX sockets are counted per family;\n"
+			"                           the state columns (estab, cl_wt, listn) apply to TCP sockets only.\n"
+			"                           The sockets are fetched from the kernel via netlink (sock_diag); when that\n"
+			"                           is not available, /proc/net/{tcp,tcp6,udp,udp6,unix} are parsed instead.\n"
 			"                           This option is only available in delta mode.\n"
                         "        -r <repeat-header> Interval for printing the header line. (only has effect in delta-mode)\n"
                         "                           -1: only print heading at start of run\n"
@@ -114,7 +189,24 @@ void print_syntax(long ticks_per_sec, long cpu_cnt, long pagesize, long physpage
                         "                           >0: heading-interval in number of lines\n"
 			"        -t                 Include threads (Light Weight Processes, LWP) in the listing.\n"
 			"                           This option does not work in delta mode.\n"
-                        "        -u <uid>           Numeric userid to filter on.  Multiple -u arguments are allowed.\n"
+			"        -T                 Print internal counters to stderr every interval: the number of sampled\n"
+			"                           processes and sample-buffer allocations, the tracked processes (with -D),\n"
+			"                           (with -s) the duration and counters of the socket scan and the socket\n"
+			"                           memory-pool (high-water mark, extends), and the wall-clock and CPU time\n"
+			"                           per phase (enumeration, socket hash-table, socket scan, smaps, accumulation,\n"
+			"                           output), so the cost of the collector itself can be measured.\n"
+                        "        -u <uid>[-<uid>]   Numeric userid, or range of userids, to filter on.\n"
+                        "                           Multiple -u arguments are allowed, there is no limit on their number.\n"
+                        "        -x <classes>       Extra columns per command, as a comma-separated list of metric classes (or all):\n"
+                        "                           flt: minor and major page faults, ctx: voluntary and involuntary context\n"
+                        "                           switches, io: bytes read from and written to storage (/proc/PID/io, in KiB),\n"
+                        "                           thr: number of threads.  Faults, switches and bytes are shown per interval,\n"
+                        "                           summed per process: a new process counts from its first sample on.\n"
+                        "                           Faults and threads come from the same read of /proc as the other metrics;\n"
+                        "                           ctx and io cost a read of /proc/PID/status and io per matched process, also during\n"
+                        "                           a full enumeration.  With -D or -e those files stay open after /proc/PID/stat, as far\n"
+                        "                           as the open-file limit allows.\n"
+                        "                           This option is only available in delta mode.\n"
                         "\n"
                         "This program collects information on the usage of the resources VSZ, RSS, and (optionally) sockets.\n"
                         "Per program, it adds up the metrics of all running instances and shows the totals.\n"
@@ -199,39 +291,52 @@ void print_syntax(long ticks_per_sec, long cpu_cnt, long pagesize, long physpage
 			"        - Memory phys pages avail:  %ld\n"
 			"        - Memory page size (bytes): %ld\n"
 			"        - Memory capacity (MB):     %ld\n"
-                        "        - Clock ticks per second:   %ld\n", cpu_cnt, physpages, physpages_avail, pagesize, physpages*pagesize/(1024*1024), ticks_per_sec);
+                        "        - Clock ticks per second:   %ld\n", TOP_GROUPS_DEFAULT, cpu_cnt, physpages, physpages_avail, pagesize, physpages*pagesize/(1024*1024), ticks_per_sec);
 }
 
 
-bool include_record(char cmd[CMD_LIST_LEN][CMD_STRING_LEN], int cmd_cnt,
-                    uid_t uid[UID_LIST_LEN], int uid_cnt, bool uid_AND_cmd,
-                    char command[CMD_STRING_LEN], uid_t userid) {
-    int i;
+// Direct-mapped cache voor de usernamen die per proces per interval nodig zijn.
+// De set van usernamen op een systeem is klein en stabiel, dus na het eerste interval
+// worden vrijwel alle lookups uit de cache beantwoord.
+static UID_CACHE_ENT uid_cache[NAME_CACHE_SIZE];
+
+const char * lookup_euser(uid_t uid) {
+    UID_CACHE_ENT *e = &uid_cache[uid & (NAME_CACHE_SIZE - 1)];
+    struct passwd *pw;
+
+    if (likely(e->used && e->uid == uid))
+        return e->euser;
+
+    // Cache-miss.  Zoek de naam op in de passwd-database (net als libproc2 dat doet:
+    // een onbekende uid wordt numeriek weergegeven).
+    if ((pw = getpwuid(uid)) != NULL) {
+        strncpy(e->euser, pw->pw_name, USER_STRING_LEN - 1);
+        e->euser[USER_STRING_LEN - 1] = '\0';
+    } else {
+        snprintf(e->euser, USER_STRING_LEN, "%u", uid);
+    }
+    e->uid  = uid;
+    e->used = true;
+    return e->euser;
+}
+
+bool include_record(cmd_matcher_t *matcher, bool uid_AND_cmd, char *command, uid_t userid) {
+    const int *idx;
     bool cmd_selected = false,
          uid_selected = false,
 	 cmd_matched  = false,
 	 uid_matched  = false,
 	 result = false;
 
-    if (cmd_cnt > 0) {
+    if (matcher->pattern_cnt > 0) {
         cmd_selected = true;
-        for (i=0; i<cmd_cnt; i++) {
-            if (strstr(command, cmd[i]) != NULL) {
-	        cmd_matched = true;
-		break;
-            }
-	}
+        cmd_matched  = cmd_matcher_find(matcher, command, &idx) > 0;
     }
 
-    if (uid_cnt > 0) {
+    if (matcher->uid_cnt > 0) {
         uid_selected = true;
         if ((uid_AND_cmd && cmd_matched) || (!uid_AND_cmd && !cmd_matched)) {
-            for (i=0; i<uid_cnt; i++) {
-                if (userid == uid[i]) {
-	            uid_matched = true;
-		    break;
-		}
-            }
+            uid_matched = cmd_matcher_uid(matcher, userid);
 	}
     }
 
@@ -247,23 +352,89 @@ bool include_record(char cmd[CMD_LIST_LEN][CMD_STRING_LEN], int cmd_cnt,
     return result;
 }
 
-void list_procs(char cmd[CMD_LIST_LEN][CMD_STRING_LEN], int cmd_cnt,
-                uid_t uid[UID_LIST_LEN], int uid_cnt, bool uid_AND_cmd,
-		LLNODE_PROCINFO *llnode_cur, bool first_iter, bool include_threads, int ticks_per_sec) {
+// Werk de set gevolgde processen bij met de process-events sinds de vorige meting (-e).
+// Een nieuw proces wordt gevolgd als zijn ouder al gevolgd wordt (fork), of als het na een
+// exec of een wijziging van naam of uid aan -c/-u voldoet.  Voldoet een gevolgd proces daarna
+// niet meer, dan wordt het niet langer gevolgd.  Geeft het aantal verwerkte events terug.
+size_t apply_proc_events(proc_events_t *events, proc_track_t *track, cmd_matcher_t *matcher, bool uid_AND_cmd) {
+    proc_track_ent_t e;
+    proc_ev_t *ev;
+    char *cmd;
+    long idx;
 
-    if (unlikely(first_iter)) {
-        if (include_threads) {
-            printf(LIST_PROCS_HEADER_FMT_STR_WITH_THREADS, LIST_PROCS_HEADER_PR_ARGS_WITH_THREADS);
+    for (size_t k=0; k<events->cnt; k++) {
+        ev  = &events->ev[k];
+        idx = proc_track_find(track, ev->pid);
+        if (ev->type == PROC_EV_FORK) {
+            long parent = proc_track_find(track, ev->ppid);
+
+            if ((idx != -1 && track->ent[idx].alive) || parent == -1 || !track->ent[parent].alive)
+                continue;
+        }
+        if (proc_track_probe(track, ev->pid, &e, &cmd) == -1) {
+            // Het proces is alweer gestopt.
+            if (idx != -1 && track->ent[idx].alive)
+                proc_track_drop(track, idx);
+            continue;
+        }
+        if (include_record(matcher, uid_AND_cmd, cmd, e.euid)) {
+            proc_track_insert(track, &e);
         } else {
-            printf(LIST_PROCS_HEADER_FMT_STR_NO_THREADS, LIST_PROCS_HEADER_PR_ARGS_NO_THREADS);
+            proc_track_close(track, &e);
+            if (idx != -1 && track->ent[idx].alive)
+                proc_track_drop(track, idx);
         }
     }
+    return events->cnt;
+}
+
+// De goedkope meting van -D/-e: verwerk de process-events en lees de gevolgde processen.
+// Geeft -1 terug als de meting onvolledig is (geen fd vrij, zie proc_track_sample()).
+int sample_tracked(proc_track_t *track, proc_events_t *events, cmd_matcher_t *matcher, bool uid_AND_cmd, PROC_SAMPLES *ps, unsigned long *events_applied) {
+    if (events) {
+        proc_events_drain(events);
+        if (!events->lost)
+            *events_applied += apply_proc_events(events, track, matcher, uid_AND_cmd);
+        proc_events_reset(events);
+    }
+    return proc_track_sample(track, ps);          // met -x ctx/io ook status en io (zie proc-track.h)
+}
 
+// Eén procesregel (of, met header, de CSV-kopregel).  De breedtes zijn die van de oude printf-layout,
+// zie LIST_PROCS_HEADER_FMT_STR_* in cmd-metrics.h.
+void list_proc_fields(out_t *o, PROC_SAMPLES *ps, size_t j, bool include_threads, int ticks_per_sec, bool header) {
+    out_rec_begin(o, header);
+    out_str(o, "", "command", ps->cmd[j], -40);
+    out_long(o, "", "pid", ps->pid[j], 8);
+    out_long(o, "", "ppid", ps->ppid[j], 8);
     if (include_threads) {
-        printf(LIST_PROCS_FMT_STR_WITH_THREADS, LIST_PROCS_PR_ARGS_WITH_THREADS);
-    } else {
-        printf(LIST_PROCS_FMT_STR_NO_THREADS, LIST_PROCS_PR_ARGS_NO_THREADS);
+        out_long(o, "", "tgid", ps->tgid[j], 8);
+        out_str(o, "", "ptype", ps->tgid[j] == ps->pid[j] ? "PROC" : "LWP", 6);
+    }
+    out_long(o, "", "euid", (int)ps->euid[j], 11);
+    out_str(o, " ", "euser", lookup_euser(ps->euid[j]), -25);
+    out_long(o, "", "vsz", ps->vsz[j], 14);
+    out_long(o, "", "rss", ps->rss[j], 14);
+    out_ticks(o, "", "utime", ps->utime[j], ticks_per_sec, 10);
+    out_ticks(o, "", "stime", ps->stime[j], ticks_per_sec, 10);
+    out_rec_end(o);
+}
+
+void list_procs(out_t *o, PROC_SAMPLES *ps, size_t j, bool first_iter, bool include_threads, int ticks_per_sec) {
+
+    if (unlikely(first_iter)) {
+        if (o->fmt == OUT_FMT_TABLE) {
+            if (include_threads) {
+                out_printf(o, LIST_PROCS_HEADER_FMT_STR_WITH_THREADS, LIST_PROCS_HEADER_PR_ARGS_WITH_THREADS);
+            } else {
+                out_printf(o, LIST_PROCS_HEADER_FMT_STR_NO_THREADS, LIST_PROCS_HEADER_PR_ARGS_NO_THREADS);
+            }
+        } else {
+            list_proc_fields(o, ps, j, include_threads, ticks_per_sec, true);
+        }
     }
+
+    list_proc_fields(o, ps, j, include_threads, ticks_per_sec, false);
 }
 
 void initialize_metrics(int cmd_cnt, CMD_METRICS *cmd_metrics) {
@@ -275,21 +446,16 @@ void initialize_metrics(int cmd_cnt, CMD_METRICS *cmd_metrics) {
             cmd_metrics[i].metric_prev.rss                    = cmd_metrics[i].metric_curr.rss;
             cmd_metrics[i].metric_prev.utime                  = cmd_metrics[i].metric_curr.utime;
             cmd_metrics[i].metric_prev.stime                  = cmd_metrics[i].metric_curr.stime;
-            cmd_metrics[i].metric_prev.sock.sock_total        = cmd_metrics[i].metric_curr.sock.sock_total;
-            cmd_metrics[i].metric_prev.sock.state.established = cmd_metrics[i].metric_curr.sock.state.established;
-            cmd_metrics[i].metric_prev.sock.state.close_wait  = cmd_metrics[i].metric_curr.sock.state.close_wait;
-            cmd_metrics[i].metric_prev.sock.state.listener    = cmd_metrics[i].metric_curr.sock.state.listener;
-            cmd_metrics[i].metric_prev.sock.state.rest        = cmd_metrics[i].metric_curr.sock.state.rest;
+            cmd_metrics[i].metric_prev.sock                   = cmd_metrics[i].metric_curr.sock;
+            cmd_metrics[i].metric_prev.extra                  = cmd_metrics[i].metric_curr.extra;
 
             cmd_metrics[i].metric_curr.vsz   = 0;
             cmd_metrics[i].metric_curr.rss   = 0;
             cmd_metrics[i].metric_curr.utime = 0;
             cmd_metrics[i].metric_curr.stime = 0;
-            cmd_metrics[i].metric_curr.sock.sock_total        = 0;
-            cmd_metrics[i].metric_curr.sock.state.established = 0;
-            cmd_metrics[i].metric_curr.sock.state.close_wait  = 0;
-            cmd_metrics[i].metric_curr.sock.state.listener    = 0;
-            cmd_metrics[i].metric_curr.sock.state.rest        = 0;
+            memset(&cmd_metrics[i].metric_curr.sock, 0, sizeof(sock_aggr_t));
+            memset(&cmd_metrics[i].metric_curr.churn, 0, sizeof(pid_churn_t));
+            memset(&cmd_metrics[i].metric_curr.extra, 0, sizeof(extra_aggr_t));
         }
     } else {
         fprintf(stderr, "ERROR: one or more commands must be specified when using the delta mode\n");
@@ -297,15 +463,52 @@ void initialize_metrics(int cmd_cnt, CMD_METRICS *cmd_metrics) {
     }
 }
 
-void accumulate_cmd_metrics(int cmd_cnt, LLNODE_PROCINFO *llnode_cur, CMD_METRICS *cmd_metrics) {
-    int i;
+void accumulate_cmd_metrics(int cmd_cnt, cmd_matcher_t *matcher, PROC_SAMPLES *ps, CMD_METRICS *cmd_metrics,
+                            pid_state_tab_t *pid_state, pid_churn_t churn[], smaps_t *smaps, unsigned int extra, self_stats_t *self) {
+    const int *idx;
+    mem_detail_t mem;
+    extra_aggr_t x;
+    bool mem_ok = false;
+    int i, k, n;
+    size_t j;
     if (cmd_cnt > 0) {
-        for (i=0; i<cmd_cnt; i++) {
-            cmd_metrics[i].process_cnt++;
-            cmd_metrics[i].metric_curr.vsz   += llnode_cur->proc_info.vsz;
-            cmd_metrics[i].metric_curr.rss   += llnode_cur->proc_info.rss;
-            cmd_metrics[i].metric_curr.utime += llnode_cur->proc_info.utime;
-            cmd_metrics[i].metric_curr.stime += llnode_cur->proc_info.stime;
+        // Alleen in de intervallen waarin smaps_rollup gelezen wordt (-M) is smaps gezet;
+        // daartussen blijft de vorige meting staan.
+        if (smaps) {
+            for (i=0; i<cmd_cnt; i++) {
+                memset(&cmd_metrics[i].mem, 0, sizeof(mem_detail_t));
+            }
+        }
+        for (j=0; j<ps->cnt; j++) {
+            // Tel het proces alleen mee bij de commando's waar het bij hoort.
+            n = cmd_matcher_find(matcher, ps->cmd[j], &idx);
+            if (smaps && n > 0) {
+                self_stats_switch(self, PHASE_SMAPS);
+                mem_ok = smaps_read(smaps, ps->pid[j], &mem) == 0;
+                self_stats_switch(self, PHASE_ACCUM);
+            }
+            if (extra && n > 0) {
+                memset(&x, 0, sizeof(extra_aggr_t));
+                extra_aggr_add(&x, ps, j);
+            }
+            for (k=0; k<n; k++) {
+                i = idx[k];
+                cmd_metrics[i].process_cnt++;
+                cmd_metrics[i].metric_curr.vsz   += ps->vsz[j];
+                cmd_metrics[i].metric_curr.rss   += ps->rss[j];
+                cmd_metrics[i].metric_curr.utime += ps->utime[j];
+                cmd_metrics[i].metric_curr.stime += ps->stime[j];
+                if (extra) {
+                    extra_aggr_add(&cmd_metrics[i].metric_curr.extra, ps, j);
+                }
+                if (pid_state) {
+                    pid_state_update(pid_state, ps->pid[j], ps->start[j], i,
+                                     ps->vsz[j], ps->rss[j], ps->utime[j], ps->stime[j], extra ? &x : NULL, &churn[i]);
+                }
+                if (smaps && mem_ok) {
+                    mem_detail_add(&cmd_metrics[i].mem, &mem);
+                }
+            }
         }
     } else {
         fprintf(stderr, "ERROR: one or more commands must be specified when using the delta mode\n");
@@ -313,116 +516,333 @@ void accumulate_cmd_metrics(int cmd_cnt, LLNODE_PROCINFO *llnode_cur, CMD_METRIC
     }
 }
 
-void accumulate_sock_metrics(char cmd[CMD_LIST_LEN][CMD_STRING_LEN], POOL **pool_ino, int cmd_cnt, CMD_METRICS *cmd_metrics, char **read_buf, long *buflen) {
-    sock_ino_ent_t *sock_ino_ent_hash[INO_HASH_SIZE];  // Node-structure voor de socket-inode hash-table
-    sock_aggr_t *s;                                    // Aggregated socket-stats voor een proces (cmd)
+// -A: tel elk proces op bij de groep van zijn procesnaam (zie cmd-group.h).  De array <groups>
+// groeit mee met het aantal groepen; een nieuwe groep begint met nullen.  Met -x houdt <pid_state>
+// per proces de tellers bij, met het nummer van de groep als commando-index.
+void accumulate_group_metrics(cmd_group_tab_t *tab, CMD_METRICS **groups, int *grp_cap, PROC_SAMPLES *ps,
+                              pid_state_tab_t *pid_state, unsigned int extra) {
+    CMD_METRICS *m;
+    extra_aggr_t x;
+    int i, cap;
+    size_t j;
+
+    for (j=0; j<ps->cnt; j++) {
+        i = cmd_group_find(tab, ps->cmd[j]);
+        if (unlikely(i >= *grp_cap)) {
+            cap = *grp_cap * 2 > i ? *grp_cap * 2 : i + 64;
+            if ((m = realloc(*groups, cap * sizeof(CMD_METRICS))) == NULL) {
+                fprintf(stderr, "ERROR: realloc() of the group table failed: %d (%s)\n", errno, strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            memset(&m[*grp_cap], 0, (cap - *grp_cap) * sizeof(CMD_METRICS));
+            *groups  = m;
+            *grp_cap = cap;
+        }
+        m = &(*groups)[i];
+        if (unlikely(m->cmd[0] == '\0'))
+            strncpy(m->cmd, ps->cmd[j], CMD_STRING_LEN - 1);
+        m->process_cnt++;
+        m->metric_curr.vsz   += ps->vsz[j];
+        m->metric_curr.rss   += ps->rss[j];
+        m->metric_curr.utime += ps->utime[j];
+        m->metric_curr.stime += ps->stime[j];
+        if (extra) {
+            extra_aggr_add(&m->metric_curr.extra, ps, j);
+            memset(&x, 0, sizeof(extra_aggr_t));
+            extra_aggr_add(&x, ps, j);
+        }
+        if (pid_state) {
+            pid_state_update(pid_state, ps->pid[j], ps->start[j], i, ps->vsz[j], ps->rss[j],
+                             ps->utime[j], ps->stime[j], extra ? &x : NULL, &m->metric_curr.churn);
+        }
+    }
+
+    // Een groep die er het vorige interval niet was (nieuw, of alle processen waren gestopt)
+    // heeft nog geen groei; anders zou elk kortlevend commando bovenaan de lijst staan.
+    for (i=0; i<tab->cnt; i++) {
+        m = &(*groups)[i];
+        if (m->metric_prev.vsz == 0 && m->metric_prev.rss == 0) {
+            m->metric_prev.vsz = m->metric_curr.vsz;
+            m->metric_prev.rss = m->metric_curr.rss;
+        }
+    }
+}
+
+static int cmp_group_growth(const void *a, const void *b) {
+    const CMD_METRICS *x = *(CMD_METRICS * const *) a;
+    const CMD_METRICS *y = *(CMD_METRICS * const *) b;
+    long dx = x->metric_curr.rss - x->metric_prev.rss;
+    long dy = y->metric_curr.rss - y->metric_prev.rss;
+
+    if (dx != dy)
+        return dx < dy ? 1 : -1;
+    if (x->metric_curr.rss != y->metric_curr.rss)
+        return x->metric_curr.rss < y->metric_curr.rss ? 1 : -1;
+    return strcmp(x->cmd, y->cmd);
+}
+
+// -A: kopieer de <top_n> groepen met de grootste groei van de RSS naar <top>, de grootste
+// eerst.  Alleen groepen met lopende processen doen mee.  Geeft het aantal groepen terug.
+int select_top_groups(int grp_cnt, CMD_METRICS *groups, CMD_METRICS **rank, int top_n, CMD_METRICS *top) {
+    int i, n = 0;
+
+    for (i=0; i<grp_cnt; i++) {
+        if (groups[i].process_cnt > 0)
+            rank[n++] = &groups[i];
+    }
+    qsort(rank, n, sizeof(CMD_METRICS *), cmp_group_growth);
+    if (n > top_n)
+        n = top_n;
+    for (i=0; i<n; i++) {
+        top[i] = *rank[i];
+    }
+    return n;
+}
+
+void accumulate_churn_metrics(int cmd_cnt, CMD_METRICS *cmd_metrics, pid_state_tab_t *pid_state, pid_churn_t churn[]) {
+    int i;
+
+    // Alle processen die in dit interval niet meer gezien zijn, zijn gestopt.
+    pid_state_sweep(pid_state, churn);
+    for (i=0; i<cmd_cnt; i++) {
+        cmd_metrics[i].metric_curr.churn = churn[i];
+    }
+}
+
+// Vul de kolommen van -g uit de files van de cgroups (zie cgroup-stats.h).  Een cgroup heeft
+// geen virtuele grootte; in de kolom vsz staat memory.current (al het geheugen van de cgroup,
+// inclusief page cache), in de kolom rss het anonieme plus het gemapte geheugen.
+void accumulate_cgroup_metrics(int cmd_cnt, int col_cnt, CMD_METRICS *cmd_metrics, int ticks_per_sec, bool first_iter) {
+    cgroup_sample_t s;
+    CMD_METRICS *m;
+    int i;
+
+    for (i=cmd_cnt; i<col_cnt; i++) {
+        m = &cmd_metrics[i];
+        cgroup_read(m->cgroup, &s);
+        m->process_cnt       = s.procs;
+        m->metric_curr.vsz   = s.mem_current;
+        m->metric_curr.rss   = s.anon + s.file_mapped;
+        m->metric_curr.utime = s.user_usec * ticks_per_sec / 1000000;
+        m->metric_curr.stime = s.system_usec * ticks_per_sec / 1000000;
+        // cpu.stat telt het verbruik van gestopte processen mee, dus het verbruik over het
+        // interval is gewoon het verschil (behalve na het herstarten van de service).
+        if (!first_iter && m->metric_curr.utime >= m->metric_prev.utime && m->metric_curr.stime >= m->metric_prev.stime) {
+            m->metric_curr.churn.utime = m->metric_curr.utime - m->metric_prev.utime;
+            m->metric_curr.churn.stime = m->metric_curr.stime - m->metric_prev.stime;
+        }
+        m->mem.pss       = s.anon + s.file_mapped;    // elke pagina telt bij precies één cgroup
+        m->mem.anon      = s.anon;
+        m->mem.anon_huge = s.anon_thp;
+        m->mem.swap      = s.swap;
+    }
+}
+
+void accumulate_leak_metrics(int cmd_cnt, CMD_METRICS *cmd_metrics) {
+    struct timespec ts;
+    double now;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = ts.tv_sec + ts.tv_nsec / 1e9;
+    for (i=0; i<cmd_cnt; i++) {
+        switch (leak_est_add(&cmd_metrics[i].leak, now, cmd_metrics[i].metric_curr.rss, cmd_metrics[i].process_cnt)) {
+        case 1:
+            fprintf(stderr, "WARNING: leak suspected for %s: RSS %+.1f MiB/h (t=%.1f)\n", cmd_metrics[i].cmd,
+                    cmd_metrics[i].leak.ew_slope * 3600 / 1024, cmd_metrics[i].leak.ew_t);
+            break;
+        case -1:
+            fprintf(stderr, "WARNING: leak no longer suspected for %s: RSS %+.1f MiB/h (t=%.1f)\n", cmd_metrics[i].cmd,
+                    cmd_metrics[i].leak.ew_slope * 3600 / 1024, cmd_metrics[i].leak.ew_t);
+            break;
+        }
+    }
+}
+
+void accumulate_sock_metrics(cmd_matcher_t *matcher, sock_ino_tab_t *sock_ino_tab, POOL *pool_ino, int sock_threads, int cmd_cnt, CMD_METRICS *cmd_metrics, char **read_buf, long *buflen, sock_scan_stats_t *stats, self_stats_t *self) {
+    sock_aggr_t s[cmd_cnt > 0 ? cmd_cnt : 1];          // Aggregated socket-stats per proces (cmd)
     int i;
     if (cmd_cnt > 0) {
-        sock_ino_build_hash_table(sock_ino_ent_hash, pool_ino, read_buf, buflen);
+        self_stats_switch(self, PHASE_SOCK_BUILD);
+        sock_ino_build_hash_table(sock_ino_tab, pool_ino, read_buf, buflen);
+        // Eén enkele doorloop van /proc voor alle commando's tegelijk.
+        self_stats_switch(self, PHASE_SOCK_GATHER);
+        sock_ino_gather_cmd_stats(sock_ino_tab, matcher, sock_threads, s, stats);
+        self_stats_switch(self, PHASE_ACCUM);
         for (i=0; i<cmd_cnt; i++) {
-            s = sock_ino_gather_cmd_stats(sock_ino_ent_hash, pool_ino, cmd[i]);
-            cmd_metrics[i].metric_curr.sock.sock_total        = s->sock_total;
-            cmd_metrics[i].metric_curr.sock.state.established = s->state.established;
-            cmd_metrics[i].metric_curr.sock.state.close_wait  = s->state.close_wait;
-            cmd_metrics[i].metric_curr.sock.state.listener    = s->state.listener;
-            cmd_metrics[i].metric_curr.sock.state.rest        = s->state.rest;
+            cmd_metrics[i].metric_curr.sock = s[i];
 	}
-        sock_ino_destroy_hash_table(sock_ino_ent_hash, *pool_ino);
+        sock_ino_destroy_hash_table(sock_ino_tab, pool_ino);
     } else {
         fprintf(stderr, "ERROR: one or more commands must be specified when using the delta mode\n");
 	exit(EXIT_FAILURE);
     }
 }
 
-void list_deltas(int cmd_cnt, CMD_METRICS *cmd_metrics, char *time_string, int ticks_per_sec, int loop_interval, int heading_interval, bool include_sockets, bool first_iter, long *line_cnt) {
+// De kolommen van één commando in list_deltas().  In de tabel-layout begint het blok met een '|'.
+void list_delta_fields(out_t *o, CMD_METRICS *m, int ticks_per_sec, bool include_sockets, bool include_churn, bool include_mem, bool include_leak, unsigned int extra, bool first_iter) {
     long delta_vsz = 0, delta_rss = 0, delta_socket = 0;
-    float utime = 0, stime = 0;
+    extra_aggr_t *d = &m->metric_curr.churn.extra;
+
+    if (!first_iter) {
+        delta_vsz = m->metric_curr.vsz - m->metric_prev.vsz;
+        delta_rss = m->metric_curr.rss - m->metric_prev.rss;
+        if (include_sockets) {
+            delta_socket = m->metric_curr.sock.sock_total - m->metric_prev.sock.sock_total;
+        }
+    }
+    out_long(o, "|", "procs", m->process_cnt, 5);
+    out_long(o, "  ", "vsz", m->metric_curr.vsz, 11);
+    out_long(o, "  ", "delta-vsz", delta_vsz, 9);
+    out_long(o, "  ", "rss", m->metric_curr.rss, 11);
+    out_long(o, "  ", "delta-rss", delta_rss, 9);
+    out_ticks(o, "  ", "utime", m->metric_curr.utime, ticks_per_sec, 8);
+    out_ticks(o, "  ", "stime", m->metric_curr.stime, ticks_per_sec, 8);
+    if (include_churn) {
+        // Het verbruik over het interval komt uit de per-PID administratie (zie pid-state.c),
+        // zodat processen die tijdens het interval gestart of gestopt zijn de berekening niet verstoren.
+        out_ticks(o, "  ", "d-utime", m->metric_curr.churn.utime, ticks_per_sec, 8);
+        out_ticks(o, "  ", "d-stime", m->metric_curr.churn.stime, ticks_per_sec, 8);
+        out_long(o, " ", "spawn", m->metric_curr.churn.spawned, 5);
+        out_long(o, " ", "exit", m->metric_curr.churn.exited, 5);
+        out_long(o, " ", "rss-freed", m->metric_curr.churn.rss_released, 11);
+    }
+    if (include_sockets) {
+        out_long(o, " ", "socks", m->metric_curr.sock.sock_total, 5);
+        out_long(o, " ", "dsock", delta_socket, 5);
+        out_long(o, " ", "estab", m->metric_curr.sock.state.established, 5);
+        out_long(o, " ", "cl_wt", m->metric_curr.sock.state.close_wait, 5);
+        out_long(o, " ", "listn", m->metric_curr.sock.state.listener, 5);
+        out_long(o, " ", "rest", m->metric_curr.sock.state.rest, 5);
+        out_long(o, " ", "tcp4", m->metric_curr.sock.family.tcp, 5);
+        out_long(o, " ", "tcp6", m->metric_curr.sock.family.tcp6, 5);
+        out_long(o, " ", "udp4", m->metric_curr.sock.family.udp, 5);
+        out_long(o, " ", "udp6", m->metric_curr.sock.family.udp6, 5);
+        out_long(o, " ", "unix", m->metric_curr.sock.family.unix_domain, 5);
+    }
+    if (include_mem) {
+        // Uit smaps_rollup, alleen bijgewerkt in de intervallen waarin die gelezen wordt (-M).
+        out_long(o, " ", "pss", m->mem.pss, 11);
+        out_long(o, " ", "uss", m->mem.uss, 11);
+        out_long(o, " ", "anon", m->mem.anon, 11);
+        out_long(o, " ", "anon-huge", m->mem.anon_huge, 11);
+        out_long(o, " ", "swap", m->mem.swap, 11);
+    }
+    if (include_leak) {
+        // Helling van de RSS in MiB/uur volgens beide schatters, en de t-waarde (zie leak-trend.h).
+        out_double(o, "  ", "rss-MiB/h", m->leak.ew_slope * 3600 / 1024, 1, 10);
+        out_double(o, " ", "win-MiB/h", m->leak.sw_slope * 3600 / 1024, 1, 10);
+        out_double(o, " ", "t", m->leak.ew_t > 999.9 ? 999.9 : (m->leak.ew_t < -999.9 ? -999.9 : m->leak.ew_t), 1, 6);
+        out_str(o, " ", "leak", m->leak.suspected ? "LEAK" : "-", 5);
+    }
+    // -x: de tellers van de processen zijn cumulatief.  De toename per interval komt uit de per-PID
+    // administratie (zie pid-state.c): een nieuw proces telt vanaf zijn eerste meting, een gestopt
+    // proces valt weg.  Een verschil van de totalen zou bij elk gestopt proces negatief worden.
+    if (extra & PROC_EXTRA_FLT) {
+        out_long(o, " ", "minflt", d->minflt, 9);
+        out_long(o, " ", "majflt", d->majflt, 9);
+    }
+    if (extra & PROC_EXTRA_CTX) {
+        out_long(o, " ", "vcsw", d->nvcsw, 9);
+        out_long(o, " ", "ivcsw", d->nivcsw, 9);
+    }
+    if (extra & PROC_EXTRA_IO) {
+        out_long(o, " ", "rd-KiB", d->read_bytes / 1024, 11);
+        out_long(o, " ", "wr-KiB", d->write_bytes / 1024, 11);
+    }
+    if (extra & PROC_EXTRA_THR) {
+        out_long(o, " ", "thr", m->metric_curr.extra.nlwp, 5);
+    }
+}
+
+// De kolomnamen van één commando in de tabel-layout van list_deltas() en list_top().
+void list_delta_heading(out_t *o, bool include_sockets, bool include_churn, bool include_mem, bool include_leak, unsigned int extra) {
+    out_printf(o, "|%5s  %11s  %9s  %11s  %9s  %8s  %8s", "procs", "vsz", "delta-vsz", "rss", "delta-rss", "utime", "stime");
+    if (include_churn) {
+        out_printf(o, "  %8s  %8s %5s %5s %11s", "d-utime", "d-stime", "spawn", "exit", "rss-freed");
+    }
+    if (include_sockets) {
+        out_printf(o, " %5s %5s %5s %5s %5s %5s %5s %5s %5s %5s %5s", "socks", "dsock", "estab", "cl_wt", "listn", "rest",
+               "tcp4", "tcp6", "udp4", "udp6", "unix");
+    }
+    if (include_mem) {
+        out_printf(o, " %11s %11s %11s %11s %11s", "pss", "uss", "anon", "anon-huge", "swap");
+    }
+    if (include_leak) {
+        out_printf(o, "  %10s %10s %6s %5s", "rss-MiB/h", "win-MiB/h", "t", "leak");
+    }
+    if (extra & PROC_EXTRA_FLT) {
+        out_printf(o, " %9s %9s", "minflt", "majflt");
+    }
+    if (extra & PROC_EXTRA_CTX) {
+        out_printf(o, " %9s %9s", "vcsw", "ivcsw");
+    }
+    if (extra & PROC_EXTRA_IO) {
+        out_printf(o, " %11s %11s", "rd-KiB", "wr-KiB");
+    }
+    if (extra & PROC_EXTRA_THR) {
+        out_printf(o, " %5s", "thr");
+    }
+}
+
+void list_deltas(out_t *o, int cmd_cnt, CMD_METRICS *cmd_metrics, char *time_string, int ticks_per_sec, double loop_interval, int heading_interval, bool include_sockets, bool include_churn, bool include_mem, bool include_leak, unsigned int extra, bool first_iter, long *line_cnt) {
+    int heading_width = LIST_DELTAS_WIDTH_BASE;
     int i;
 
+    if (include_churn)
+        heading_width += LIST_DELTAS_WIDTH_CHURN;
+    if (include_sockets)
+        heading_width += LIST_DELTAS_WIDTH_SOCKETS;
+    if (include_mem)
+        heading_width += LIST_DELTAS_WIDTH_MEM;
+    if (include_leak)
+        heading_width += LIST_DELTAS_WIDTH_LEAK;
+    if (extra & PROC_EXTRA_FLT)
+        heading_width += LIST_DELTAS_WIDTH_FLT;
+    if (extra & PROC_EXTRA_CTX)
+        heading_width += LIST_DELTAS_WIDTH_CTX;
+    if (extra & PROC_EXTRA_IO)
+        heading_width += LIST_DELTAS_WIDTH_IO;
+    if (extra & PROC_EXTRA_THR)
+        heading_width += LIST_DELTAS_WIDTH_THR;
+
     if (cmd_cnt > 0) {
+        if (o->fmt != OUT_FMT_TABLE) {
+            // CSV en JSON Lines: één record per commando, met de datetime en de commandonaam erbij.
+            // De CSV-kopregel komt alleen bovenaan; -r is alleen voor de tabel-layout.
+            for (i=(first_iter ? -1 : 0); i<cmd_cnt; i++) {
+                out_rec_begin(o, i < 0);
+                out_str(o, "", "datetime", time_string, 0);
+                out_str(o, "", "command", cmd_metrics[i < 0 ? 0 : i].cmd, 0);
+                list_delta_fields(o, &cmd_metrics[i < 0 ? 0 : i], ticks_per_sec, include_sockets, include_churn, include_mem, include_leak, extra, first_iter);
+                out_rec_end(o);
+            }
+            *line_cnt += 1;
+            return;
+        }
         // druk de kopregels af
         if ((first_iter && heading_interval == -1) ||
             (heading_interval > 0 && (*line_cnt % heading_interval == 0))) {
             // druk eerste heading-regel af (procesnamen)
-            printf("%14s", " ");
+            out_printf(o, "%14s", " ");
             for (i=0; i<cmd_cnt; i++) {
-                if (include_sockets) {
-                    printf("|%-109s", cmd_metrics[i].cmd);
-                } else {
-                    printf("|%-73s", cmd_metrics[i].cmd);
-                }
+                out_printf(o, "|%-*s", heading_width, cmd_metrics[i].cmd);
             }
-	    printf("\n");
+	    out_printf(o, "\n");
             // druk tweede heading-regel af (kolomnamen)
-            printf("%-14s", "datetime");
+            out_printf(o, "%-14s", "datetime");
             for (i=0; i<cmd_cnt; i++) {
-                if (include_sockets) {
-                    printf("|%5s  %11s  %9s  %11s  %9s  %8s  %8s %5s %5s %5s %5s %5s %5s", "procs", "vsz", "delta-vsz", "rss", "delta-rss", "utime", "stime",
-		                                                                           "socks", "dsock", "estab", "cl_wt", "listn", "rest");
-                } else {
-                    printf("|%5s  %11s  %9s  %11s  %9s  %8s  %8s", "procs", "vsz", "delta-vsz", "rss", "delta-rss", "utime", "stime");
-                }
+                list_delta_heading(o, include_sockets, include_churn, include_mem, include_leak, extra);
             }
-	    printf("\n");
+	    out_printf(o, "\n");
         }
         // druk de metrics-regel af
-        printf("%14s", time_string);
+        out_rec_begin(o, false);
+        out_str(o, "", "datetime", time_string, 14);
         for (i=0; i<cmd_cnt; i++) {
-            if (!first_iter) {
-                delta_vsz = cmd_metrics[i].metric_curr.vsz - cmd_metrics[i].metric_prev.vsz;
-                delta_rss = cmd_metrics[i].metric_curr.rss - cmd_metrics[i].metric_prev.rss;
-                if (include_sockets) {
-                    delta_socket = cmd_metrics[i].metric_curr.sock.sock_total - cmd_metrics[i].metric_prev.sock.sock_total;
-                }
-                // Het kan voorkomen dat één of meer processen tijdens de meetinterval gestopt zijn.
-                // De ticks van die processen telden dan nog wel mee in prev maar niet curr.
-                // Hierdoor kan in zo'n geval de berekening incidenteel negatief worden.
-                // Om dit te voorkomen zetten we utime en stime in zo'n geval op 0.
-                // Dit is natuurlijk eigenlijk niet netjes, maar anders moeten we van ALLE processen
-                // de context gaan bijhouden, en de in curr weggevallen processen ook negeren in prev.
-                // Dit is teveel werk.
-                if (cmd_metrics[i].metric_prev.utime < cmd_metrics[i].metric_curr.utime) {
-                    utime = ((float)cmd_metrics[i].metric_curr.utime - (float)cmd_metrics[i].metric_prev.utime)/ticks_per_sec;
-                } else {
-                    utime = (float) 0.0;
-                }
-                if (cmd_metrics[i].metric_prev.stime < cmd_metrics[i].metric_curr.stime) {
-                    stime = ((float)cmd_metrics[i].metric_curr.stime - (float)cmd_metrics[i].metric_prev.stime)/ticks_per_sec;
-                } else {
-                    stime = (float) 0.0;
-                }
-            }
-            if (include_sockets) {
-                printf("|%5d  %11ld  %9ld  %11ld  %9ld  %8.2f  %8.2f %5ld %5ld %5ld %5ld %5ld %5ld",
-                    cmd_metrics[i].process_cnt,
-                    cmd_metrics[i].metric_curr.vsz,
-                    delta_vsz,
-                    cmd_metrics[i].metric_curr.rss,
-                    delta_rss,
-//                    utime,   // Liever de totaaltelling dan de meting over het interval (zie hieronder)
-//                    stime,   // Liever de totaaltelling dan de meting over het interval (zie hieronder)
-                    ((float)cmd_metrics[i].metric_curr.utime)/ticks_per_sec,
-                    ((float)cmd_metrics[i].metric_curr.stime)/ticks_per_sec,
-                    cmd_metrics[i].metric_curr.sock.sock_total,
-                    delta_socket,
-                    cmd_metrics[i].metric_curr.sock.state.established,
-                    cmd_metrics[i].metric_curr.sock.state.close_wait,
-                    cmd_metrics[i].metric_curr.sock.state.listener,
-                    cmd_metrics[i].metric_curr.sock.state.rest);
-            } else {
-                printf("|%5d  %11ld  %9ld  %11ld  %9ld  %8.2f  %8.2f",
-                    cmd_metrics[i].process_cnt,
-                    cmd_metrics[i].metric_curr.vsz,
-                    delta_vsz,
-                    cmd_metrics[i].metric_curr.rss,
-                    delta_rss,
-//                    utime,   // Liever de totaaltelling dan de meting over het interval (zie hieronder)
-//                    stime,   // Liever de totaaltelling dan de meting over het interval (zie hieronder)
-                    ((float)cmd_metrics[i].metric_curr.utime)/ticks_per_sec,
-                    ((float)cmd_metrics[i].metric_curr.stime)/ticks_per_sec);
-            }
+            list_delta_fields(o, &cmd_metrics[i], ticks_per_sec, include_sockets, include_churn, include_mem, include_leak, extra, first_iter);
         }
-	printf("\n");
+        out_rec_end(o);
         *line_cnt += 1;  // hier hogen we de globale variable op, dit blijft dus behouden
     } else {
         fprintf(stderr, "ERROR: one or more commands must be specified when using the delta mode\n");
@@ -430,49 +850,90 @@ void list_deltas(int cmd_cnt, CMD_METRICS *cmd_metrics, char *time_string, int t
     }
 }
 
-void populate_linked_list_node(LLNODE_PROCINFO * llnode_new) {
-    memset(llnode_new, 0, sizeof(LLNODE_PROCINFO));
-    strncpy(llnode_new->proc_info.cmd, PIDS_VAL(pids_cmd,     str,     pids_stack_data), CMD_STRING_LEN);
-    llnode_new->proc_info.euid  = PIDS_VAL(pids_euid,         u_int,   pids_stack_data);
-    strncpy(llnode_new->proc_info.euser, PIDS_VAL(pids_euser, str,     pids_stack_data), CMD_STRING_LEN);
-    llnode_new->proc_info.pid   = PIDS_VAL(pids_pid,          s_int,   pids_stack_data);
-    llnode_new->proc_info.ppid  = PIDS_VAL(pids_ppid,         s_int,   pids_stack_data);
-    llnode_new->proc_info.tgid  = PIDS_VAL(pids_tgid,         s_int,   pids_stack_data);
-    llnode_new->proc_info.vsz   = PIDS_VAL(pids_vsz,          ul_int,  pids_stack_data);
-    llnode_new->proc_info.rss   = PIDS_VAL(pids_rss,          ul_int,  pids_stack_data);
-    llnode_new->proc_info.utime = PIDS_VAL(pids_utime,        ull_int, pids_stack_data);
-    llnode_new->proc_info.stime = PIDS_VAL(pids_stime,        ull_int, pids_stack_data);
-    llnode_new->next = NULL;
+// -A: de groepen uit select_top_groups(), in de tabel-layout één regel per groep (de kolommen
+// wisselen van interval tot interval, dus een kolomblok per groep zoals bij -c kan niet).
+// CSV en JSON Lines hebben al één record per commando; die gaan via list_deltas().
+void list_top(out_t *o, int top_cnt, CMD_METRICS *top, char *time_string, int ticks_per_sec, double loop_interval, int heading_interval, unsigned int extra, bool first_iter, long *line_cnt) {
+    int i;
+
+    if (o->fmt != OUT_FMT_TABLE) {
+        if (top_cnt > 0)
+            list_deltas(o, top_cnt, top, time_string, ticks_per_sec, loop_interval, heading_interval, false, false, false, false, extra, first_iter, line_cnt);
+        return;
+    }
+    if ((first_iter && heading_interval == -1) ||
+        (heading_interval > 0 && (*line_cnt % heading_interval == 0))) {
+        out_printf(o, "%-14s|%-15s", "datetime", "command");
+        list_delta_heading(o, false, false, false, false, extra);
+        out_printf(o, "\n");
+    }
+    for (i=0; i<top_cnt; i++) {
+        out_rec_begin(o, false);
+        out_str(o, "", "datetime", time_string, 14);
+        out_str(o, "|", "command", top[i].cmd, -15);
+        list_delta_fields(o, &top[i], ticks_per_sec, false, false, false, false, extra, first_iter);
+        out_rec_end(o);
+    }
+    *line_cnt += 1;
 }
 
-void add_linked_list_node(LLNODE_PROCINFO **llnode_start, LLNODE_PROCINFO **llnode_cur) {
-    LLNODE_PROCINFO *llnode_new = NULL;
-
-    llnode_new = (struct procinfo_node *)malloc(sizeof(LLNODE_PROCINFO));
-    populate_linked_list_node(llnode_new);
-    if (*llnode_start == NULL) {
-         // Dit is de eerste iteratie, special case...
-         *llnode_start = llnode_new;
-         *llnode_cur   = llnode_new;
-     } else {
-         // Alle volgende nodes
-         (*llnode_cur)->next = llnode_new;
-         *llnode_cur         = llnode_new;
-     }
+void add_proc_sample(PROC_SAMPLES *ps) {
+    size_t j = proc_samples_add(ps);
+
+    // De usernaam wordt niet opgeslagen; list_procs() zoekt hem op via lookup_euser().
+    strncpy(ps->cmd[j], PIDS_VAL(pids_cmd, str, pids_stack_data), CMD_STRING_LEN - 1);
+    ps->cmd[j][CMD_STRING_LEN - 1] = '\0';
+    ps->euid[j]  = PIDS_VAL(pids_euid,  u_int,   pids_stack_data);
+    ps->pid[j]   = PIDS_VAL(pids_pid,   s_int,   pids_stack_data);
+    ps->ppid[j]  = PIDS_VAL(pids_ppid,  s_int,   pids_stack_data);
+    ps->tgid[j]  = PIDS_VAL(pids_tgid,  s_int,   pids_stack_data);
+    ps->vsz[j]   = PIDS_VAL(pids_vsz,   ul_int,  pids_stack_data);
+    ps->rss[j]   = PIDS_VAL(pids_rss,   ul_int,  pids_stack_data);
+    ps->utime[j] = PIDS_VAL(pids_utime, ull_int, pids_stack_data);
+    ps->stime[j] = PIDS_VAL(pids_stime, ull_int, pids_stack_data);
+    ps->start[j] = PIDS_VAL(pids_start, ull_int, pids_stack_data);
+    // De velden van -x; die van niet gevraagde klassen zijn PIDS_noop en worden niet gebruikt.
+    ps->minflt[j]      = PIDS_VAL(pids_minflt,      ul_int, pids_stack_data);
+    ps->majflt[j]      = PIDS_VAL(pids_majflt,      ul_int, pids_stack_data);
+    ps->nlwp[j]        = PIDS_VAL(pids_nlwp,        s_int,  pids_stack_data);
 }
 
-void destroy_linked_list(LLNODE_PROCINFO *llnode_start) {
-    LLNODE_PROCINFO *llnode_cur = NULL,
-                    *llnode_prv = NULL;
+// Zet de metingen van dit interval om naar de vaste records van ring-out.h.
+// Die worden gebruikt door de ring-buffer (-m) en het metrics-endpoint (-P).
+void fill_cmd_recs(ring_cmd_rec_t *c, int cmd_cnt, CMD_METRICS *cmd_metrics) {
+    int i;
 
-    llnode_cur = llnode_start;
-    while (llnode_cur != NULL) {
-        llnode_prv = llnode_cur;
-	llnode_cur = llnode_cur->next;
-	free(llnode_prv);
+    for (i=0; i<cmd_cnt; i++) {
+        c[i].process_cnt        = cmd_metrics[i].process_cnt;
+        c[i].vsz                = cmd_metrics[i].metric_curr.vsz;
+        c[i].rss                = cmd_metrics[i].metric_curr.rss;
+        c[i].utime              = cmd_metrics[i].metric_curr.utime;
+        c[i].stime              = cmd_metrics[i].metric_curr.stime;
+        c[i].churn_utime        = cmd_metrics[i].metric_curr.churn.utime;
+        c[i].churn_stime        = cmd_metrics[i].metric_curr.churn.stime;
+        c[i].churn_spawned      = cmd_metrics[i].metric_curr.churn.spawned;
+        c[i].churn_exited       = cmd_metrics[i].metric_curr.churn.exited;
+        c[i].churn_rss_released = cmd_metrics[i].metric_curr.churn.rss_released;
+        c[i].sock_total         = cmd_metrics[i].metric_curr.sock.sock_total;
+        c[i].sock_established   = cmd_metrics[i].metric_curr.sock.state.established;
+        c[i].sock_close_wait    = cmd_metrics[i].metric_curr.sock.state.close_wait;
+        c[i].sock_listener      = cmd_metrics[i].metric_curr.sock.state.listener;
+        c[i].sock_rest          = cmd_metrics[i].metric_curr.sock.state.rest;
+        c[i].sock_tcp           = cmd_metrics[i].metric_curr.sock.family.tcp;
+        c[i].sock_tcp6          = cmd_metrics[i].metric_curr.sock.family.tcp6;
+        c[i].sock_udp           = cmd_metrics[i].metric_curr.sock.family.udp;
+        c[i].sock_udp6          = cmd_metrics[i].metric_curr.sock.family.udp6;
+        c[i].sock_unix          = cmd_metrics[i].metric_curr.sock.family.unix_domain;
     }
 }
 
+int64_t sample_time_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 void current_time(char *time_string) {
     time_t timestamp;
     struct tm* tm_info;
@@ -489,29 +950,73 @@ int main(int argc, char **argv) {
     long physpages_avail = sysconf(_SC_AVPHYS_PAGES);     // physical pages beschikbaar
     long cpu_cnt         = sysconf(_SC_NPROCESSORS_ONLN); // aantal actieve CPU's
     long ticks_per_sec   = sysconf(_SC_CLK_TCK);          // vraag de clock ticks/seconde op (verschilt van systeem tot systeem)
-    char cmd[CMD_LIST_LEN][CMD_STRING_LEN];    // array van programmanamen waarop gefilterd moet worden
-    char command[CMD_STRING_LEN];              // werkvariable voor bovenstaande array
-    uid_t uid[UID_LIST_LEN];                   // array van UID's waaop gefilterd moet worden
+    cmd_matcher_t *matcher;                    // gecompileerde filter voor de programmanamen (-c) en UID's (-u)
+    unsigned long uid_lo, uid_hi;              // werkvariabelen voor het parsen van een UID (-range)
     uid_t userid;                              // werkvariable voor bovenstaande array
     bool delta_mode = false;                   // start op in delta-mode yes/no
     bool uid_AND_cmd = false;                  // when specifying uid as well as cmd, they should both match (or not)
-    bool include_sockets = false;              // verzamel ook de tellingen van de TCP-sockets
+    bool include_sockets = false;              // verzamel ook de tellingen van de sockets
     bool include_threads = false;              // vraag ook de threads (LWP's) van de processen op
+    bool include_churn = false;                // houd per proces de vorige meting bij (gestarte/gestopte processen, CPU per interval)
+    bool include_leak = false;                 // schat de trend van de RSS per commando (-L)
+    unsigned int extra = 0;                    // PROC_EXTRA_*: de klassen van -x
+    proc_extra_t *pextra = NULL;               // lezer voor /proc/PID/status en io (-x ctx, io)
+    unsigned int extra_read = 0;               // de klassen die in dit interval door pextra gelezen worden
+    bool group_all = false;                    // groepeer alle processen op procesnaam (-A)
+    bool include_events = false;               // volg nieuwe processen via de process-events van de kernel (-e)
+    bool show_timing = false;                  // druk per interval tellingen en doorlooptijden af op stderr
     bool first_iter = true;
     int uid_cnt = 0;
     int cmd_cnt = 0;
-    int loop_interval = 0;                     // meet-interval (in seconden)
+    int cg_cnt = 0;                            // aantal cgroups (-g)
+    int col_cnt;                               // aantal kolommen: eerst de commando's, dan de cgroups
+    char **cg_name = NULL;                     // de opgegeven cgroups
+    char **col_name = NULL;                    // de namen van alle kolommen (voor -m en -P)
+    double loop_interval = 0;                  // meet-interval (in seconden)
+    tick_loop_t *loop = NULL;                  // interval-timer en signals (alleen met -i)
+    int loop_ev, signo;
     int heading_interval = -1;                 // interval (in lines) waarmee de heading moet worden afgedrukt
+    int mem_interval = 0;                      // interval (in metingen) waarmee smaps_rollup gelezen wordt (-M)
+    smaps_t *smaps = NULL;
+    self_stats_t self_stats, *self = NULL;     // doorlooptijd en CPU-tijd per fase (alleen met -T)
+    unsigned long sock_cnt = 0;                // aantal sockets in de hash-table (voor -T)
+    long enum_cnt = 0;                         // aantal doorzochte processen (voor -T)
+    int leak_minutes = 0;                      // venster van de trend-schatting (-L), in minuten
+    int discover_interval = 1;                 // interval (in metingen) waarmee alle processen worden opgevraagd (-D)
+    unsigned long iter_cnt = 0;                // volgnummer van de huidige meting
+    int sock_threads = 1;                      // aantal threads voor de socket-scan (-j)
+    char *ring_path = NULL;                    // bestand voor de binaire ring-buffer output (-m)
+    ring_t *ring = NULL;
+    out_fmt_t out_fmt = OUT_FMT_TABLE;         // layout van de output (-o)
+    out_t *out;
+    char *prom_addr = NULL;                    // listen-adres van het metrics-endpoint (-P)
+    prom_t *prom = NULL;
+    ring_cmd_rec_t *prom_recs = NULL;
+    unsigned int out_flags;                    // RING_FLAG_*: welke optionele metingen er zijn
     long line_cnt = 0;
     int i;
     char time_string[TIME_STRING_LEN];
     int option;
-    char *optstring = "ac:dhi:r:stu:";
+    char *optstring = "aAc:dD:eg:hi:j:L:m:M:n:o:pP:r:stTu:x:";
     char *end_ptr;
-    POOL *pool_ino;
-    POOL **pool_ino_pp = &pool_ino;
+    POOL *pool_ino = NULL;
+    sock_ino_tab_t *sock_ino_tab = NULL;       // socket-inode hash-table, hergebruikt van interval tot interval
     char *read_buf = NULL;
     long buflen = INITIAL_READBUF_SIZE;
+    sock_scan_stats_t sock_scan_stats;         // tellingen en doorlooptijd van de laatste socket-scan
+    pid_state_tab_t *pid_state = NULL;         // per-PID administratie voor de optie -p
+    pid_churn_t *churn = NULL;                 // werkvariabele voor de resultaten van de per-PID administratie
+    proc_track_t *track = NULL;                // gevolgde processen voor de goedkope sample-modus (-D)
+    cmd_group_tab_t *grp_tab = NULL;           // procesnamen en hun groepsnummer (-A)
+    CMD_METRICS *groups = NULL;                // de metingen per groep, op groepsnummer (-A)
+    CMD_METRICS **grp_rank = NULL;             // werkarray voor het sorteren van de groepen
+    CMD_METRICS *top = NULL;                   // de getoonde groepen van dit interval
+    int grp_cap = 0, rank_cap = 0;
+    int top_n = TOP_GROUPS_DEFAULT;            // aantal getoonde groepen (-n)
+    int top_cnt = 0;
+    proc_events_t *events = NULL;              // process-events van de kernel (-e)
+    unsigned long events_applied = 0;          // aantal verwerkte process-events (voor -T)
+    bool discover_set = false;                 // -D is opgegeven
 
     // Vraag de naam op van de file waar stdout naar schrijft (is waarschijnlijk gezet dmv een redirect).
     // Dit hebben we nodig voor de freopen van stdout in geval van een SIGHUP.
@@ -530,11 +1035,15 @@ int main(int argc, char **argv) {
     sigaction(SIGINT, &sa, NULL);     // Vang SIGINT af om de stdout-buffer te flushen voordat we stoppen
     sa.sa_handler = SIGHUP_handler;
     sigaction(SIGHUP, &sa, NULL);     // Vang SIGHUP af om stdout te kunnen heropenen na logfile rotation
-    sa.sa_handler = SIGALRM_handler;
-    sigaction(SIGALRM, &sa, NULL);    // Vang SIGALRM af ten behoeve van setitimer(). De handler is een no-op.
 
-    // Maak de aggregatietabel voor de metingen aan.
-    CMD_METRICS cmd_metrics[CMD_LIST_LEN];
+    // De aggregatietabel voor de metingen wordt aangemaakt zodra het aantal commando's bekend is.
+    CMD_METRICS *cmd_metrics = NULL;
+
+    matcher = cmd_matcher_create();
+    if ((cg_name = calloc(argc, sizeof(char *))) == NULL) {
+        fprintf(stderr, "ERROR: calloc() of the cgroup list failed: %d (%s)\n", errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 
     opterr = 0;
     option = getopt(argc, argv, optstring);
@@ -542,15 +1051,60 @@ int main(int argc, char **argv) {
         switch (option) {
 	case 'a': uid_AND_cmd = true;
 	          break;
-	case 'c': if (cmd_cnt >= CMD_LIST_LEN) {
-        	      fprintf(stderr, "ERROR: too many commands (-c) specified (maximum %d allowed)\n", CMD_LIST_LEN);
-                      exit(EXIT_FAILURE);
-                  }
-                  strncpy(cmd[cmd_cnt], optarg, CMD_STRING_LEN);
+        case 'A': group_all = true;
+                  break;
+	case 'c': cmd_matcher_add_cmd(matcher, optarg);
                   cmd_cnt++;
 		  break;
         case 'd': delta_mode = true;
                   break;
+        case 'e': include_events = true;
+                  break;
+        case 'g': cg_name[cg_cnt++] = optarg;
+                  break;
+        case 'D': discover_interval = strtol(optarg, &end_ptr, 10);
+                  if (*end_ptr != '\0' || discover_interval < 1) {
+        	      fprintf(stderr, "ERROR: discovery-interval (-D) must be a positive integer\n");
+                      exit(EXIT_FAILURE);
+                  }
+                  discover_set = true;
+                  break;
+        case 'j': sock_threads = strtol(optarg, &end_ptr, 10);
+                  if (*end_ptr != '\0' || sock_threads < 1) {
+        	      fprintf(stderr, "ERROR: number of threads (-j) must be a positive integer\n");
+                      exit(EXIT_FAILURE);
+                  }
+                  break;
+        case 'L': leak_minutes = strtol(optarg, &end_ptr, 10);
+                  if (*end_ptr != '\0' || leak_minutes < 1) {
+        	      fprintf(stderr, "ERROR: leak-trend window (-L) must be a positive number of minutes\n");
+                      exit(EXIT_FAILURE);
+                  }
+                  include_leak = true;
+                  break;
+        case 'm': ring_path = optarg;
+                  break;
+        case 'M': mem_interval = strtol(optarg, &end_ptr, 10);
+                  if (*end_ptr != '\0' || mem_interval < 1) {
+        	      fprintf(stderr, "ERROR: smaps-interval (-M) must be a positive integer\n");
+                      exit(EXIT_FAILURE);
+                  }
+                  break;
+        case 'n': top_n = strtol(optarg, &end_ptr, 10);
+                  if (*end_ptr != '\0' || top_n < 1) {
+        	      fprintf(stderr, "ERROR: number of groups (-n) must be a positive integer\n");
+                      exit(EXIT_FAILURE);
+                  }
+                  break;
+        case 'o': if (out_parse_fmt(optarg, &out_fmt) != 0) {
+        	      fprintf(stderr, "ERROR: output format (-o) must be one of table, csv or json\n");
+                      exit(EXIT_FAILURE);
+                  }
+                  break;
+        case 'p': include_churn = true;
+                  break;
+        case 'P': prom_addr = optarg;
+                  break;
         case 'r': heading_interval = strtol(optarg, &end_ptr, 10);
                   if (*end_ptr != '\0') {
         	      fprintf(stderr, "ERROR: repeat-header (-r) must be either -1, 0 or a positive integer\n");
@@ -561,29 +1115,31 @@ int main(int argc, char **argv) {
                   break;
         case 't': include_threads = true;
                   break;
-        case 'i': loop_interval = strtol(optarg, &end_ptr, 10);
-                  if (*end_ptr != '\0') {
-        	      fprintf(stderr, "ERROR: loop-interval (-i) must be a positive integer\n");
+        case 'T': show_timing = true;
+                  break;
+        case 'i': loop_interval = strtod(optarg, &end_ptr);
+                  if (*end_ptr != '\0' || end_ptr == optarg || loop_interval < 0 || (loop_interval > 0 && loop_interval < 0.001)) {
+        	      fprintf(stderr, "ERROR: loop-interval (-i) must be a positive number of seconds (at least 0.001)\n");
                       exit(EXIT_FAILURE);
                   }
-                  struct itimerval timer;
-                  timer.it_value.tv_sec = loop_interval;
-                  timer.it_value.tv_usec = 0;
-                  timer.it_interval.tv_sec = loop_interval;
-                  timer.it_interval.tv_usec = 0;
-                  setitimer(ITIMER_REAL, &timer, NULL);
                   break;
-        case 'u': if (uid_cnt >= UID_LIST_LEN) {
-                      fprintf(stderr, "ERROR: too many uid's (-u) specified\n");
-                      exit(EXIT_FAILURE);
+        case 'u': uid_lo = strtoul(optarg, &end_ptr, 10);
+                  uid_hi = uid_lo;
+                  if (*end_ptr == '-' && end_ptr != optarg) {
+                      uid_hi = strtoul(end_ptr + 1, &end_ptr, 10);
                   }
-                  uid[uid_cnt] = strtol(optarg, &end_ptr, 10);
-                  if (*end_ptr != '\0') {
-                      fprintf(stderr, "ERROR: UID (-u) must be a positive integer\n");
+                  if (*end_ptr != '\0' || *optarg == '-' || uid_hi < uid_lo || uid_hi > UINT_MAX) {
+                      fprintf(stderr, "ERROR: UID (-u) must be a positive integer or a range of positive integers (<uid>-<uid>)\n");
                       exit(EXIT_FAILURE);
                   }
+                  cmd_matcher_add_uid(matcher, uid_lo, uid_hi);
                   uid_cnt++;
                   break;
+        case 'x': if (proc_extra_parse(optarg, &extra) != 0) {
+        	      fprintf(stderr, "ERROR: metric classes (-x) must be a comma-separated list of flt, ctx, io and thr, or all\n");
+                      exit(EXIT_FAILURE);
+                  }
+                  break;
         case 'h': 
         default:  print_syntax(ticks_per_sec, cpu_cnt, pagesize, physpages, physpages_avail);
                   exit(EXIT_FAILURE);
@@ -601,101 +1157,376 @@ int main(int argc, char **argv) {
 	exit(EXIT_FAILURE);
     }
 
-    // Voor delta-processing, plaats de opgegeven cmd-namen in de cmd_metrics tabel
+    if (sock_threads > 1 && !include_sockets) {
+        fprintf(stderr, "ERROR: the threads option (-j) only applies to the sockets option (-s).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (ring_path && !delta_mode) {
+        fprintf(stderr, "ERROR: the ring-buffer option (-m) is only supported in delta-mode (-d).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (prom_addr && (!delta_mode || loop_interval <= 0)) {
+        fprintf(stderr, "ERROR: the metrics endpoint (-P) is only supported in delta-mode (-d) with an interval (-i).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (include_leak && (!delta_mode || loop_interval <= 0)) {
+        fprintf(stderr, "ERROR: the leak-trend option (-L) is only supported in delta-mode (-d) with an interval (-i).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (mem_interval > 0 && !delta_mode) {
+        fprintf(stderr, "ERROR: the smaps option (-M) is only supported in delta-mode (-d).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (include_churn && !delta_mode) {
+        fprintf(stderr, "ERROR: the process churn option (-p) is only supported in delta-mode (-d).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (cg_cnt > 0 && !delta_mode) {
+        fprintf(stderr, "ERROR: the cgroup option (-g) is only supported in delta-mode (-d).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (discover_interval > 1 && !delta_mode) {
+        fprintf(stderr, "ERROR: the discovery-interval option (-D) is only supported in delta-mode (-d).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (include_events && (!delta_mode || loop_interval <= 0)) {
+        fprintf(stderr, "ERROR: the process-events option (-e) is only supported in delta-mode (-d) with an interval (-i).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (extra && !delta_mode) {
+        fprintf(stderr, "ERROR: the metric classes option (-x) is only supported in delta-mode (-d).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (group_all && !delta_mode) {
+        fprintf(stderr, "ERROR: the group-by-command option (-A) is only supported in delta-mode (-d).\n");
+	exit(EXIT_FAILURE);
+    }
+
+    if (group_all && (cmd_cnt > 0 || cg_cnt > 0 || discover_set || include_events || include_leak || ring_path ||
+                      mem_interval > 0 || include_churn || prom_addr || include_sockets)) {
+        fprintf(stderr, "ERROR: the group-by-command option (-A) cannot be combined with -c, -D, -e, -g, -L, -m, -M, -p, -P or -s.\n");
+	exit(EXIT_FAILURE);
+    }
+
+    // Met -e is de volledige enumeratie alleen nog een periodieke controle.
+    if (include_events && !discover_set)
+        discover_interval = PROC_EVENTS_RESCAN;
+
+    // Voor delta-processing, plaats de opgegeven cmd-namen en daarachter de cgroups in de cmd_metrics tabel
+    col_cnt = cmd_cnt + cg_cnt;
     if (delta_mode) {
-        if (cmd_cnt > 0) {
-	    for (i=0; i<cmd_cnt; i++) {
-	        strncpy(cmd_metrics[i].cmd, cmd[i], CMD_STRING_LEN);
+        if (col_cnt > 0) {
+            if ((cmd_metrics = calloc(col_cnt, sizeof(CMD_METRICS))) == NULL ||
+                (churn = calloc(cmd_cnt > 0 ? cmd_cnt : 1, sizeof(pid_churn_t))) == NULL ||
+                (col_name = calloc(col_cnt, sizeof(char *))) == NULL) {
+                fprintf(stderr, "ERROR: calloc() of the metrics table failed: %d (%s)\n", errno, strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+	    for (i=0; i<col_cnt; i++) {
+                col_name[i] = i < cmd_cnt ? matcher->pattern[i] : cg_name[i - cmd_cnt];
+	        strncpy(cmd_metrics[i].cmd, col_name[i], CMD_STRING_LEN - 1);
+                if (i >= cmd_cnt) {
+                    cmd_metrics[i].cgroup = cgroup_create(col_name[i]);
+                }
+                if (include_leak) {
+                    leak_est_init(&cmd_metrics[i].leak, leak_minutes * 60 / loop_interval > LEAK_WINDOW_MAX ?
+                                  LEAK_WINDOW_MAX : (int)(leak_minutes * 60 / loop_interval), leak_minutes * 60);
+                }
+            }
+	} else if (group_all) {
+            // De groepen ontstaan pas tijdens de metingen (zie accumulate_group_metrics()).
+            grp_tab = cmd_group_create();
+            if ((top = calloc(top_n, sizeof(CMD_METRICS))) == NULL) {
+                fprintf(stderr, "ERROR: calloc() of the metrics table failed: %d (%s)\n", errno, strerror(errno));
+                exit(EXIT_FAILURE);
             }
 	} else {
-            fprintf(stderr, "ERROR: when using the delta mode (-d), please specify one or more commands (-c)\n");
+            fprintf(stderr, "ERROR: when using the delta mode (-d), please specify one or more commands (-c), cgroups (-g) or -A\n");
 	    exit(EXIT_FAILURE);
 	}
     }
 
-    // Creëer de memory-pool voor de opslag van de socket-hashtabel.
-    if (include_sockets)
+    // Creëer de output-buffer voor list_procs() en list_deltas().
+    out = out_create(out_fmt);
+
+    // Creëer de binaire ring-buffer output.
+    out_flags = (include_sockets ? RING_FLAG_SOCKETS : 0) | (include_churn ? RING_FLAG_CHURN : 0);
+    if (ring_path)
+        ring = ring_out_create(ring_path, RING_SLOTS_DEFAULT, col_cnt, col_name, ticks_per_sec, out_flags);
+
+    // Start de interval-timer.  Dat moet voordat de threads van -j gestart worden (zie tick-loop.c).
+    if (loop_interval > 0)
+        loop = tick_loop_create(loop_interval);
+
+    // Creëer het metrics-endpoint en neem het op in de wacht-loop.
+    if (prom_addr) {
+        if ((prom_recs = calloc(col_cnt, sizeof(ring_cmd_rec_t))) == NULL) {
+            fprintf(stderr, "ERROR: calloc() of the metrics records failed: %d (%s)\n", errno, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        prom = prom_create(prom_addr);
+        tick_loop_add_fd(loop, prom_fd(prom));
+    }
+
+    // Creëer de memory-pool en de hash-table voor de opslag van de socket-gegevens.
+    if (include_sockets) {
         pool_ino = pool_create(POOL_SIZE_INO);
+        sock_ino_tab = sock_ino_tab_create();
+        sock_ino_par_start(sock_threads);         // workers voor -j, blijven de hele run bestaan
+    }
 
-    // Definieer pointers naar de nodes voor de procps linked list.
-    LLNODE_PROCINFO *llnode_start = NULL,
-                    *llnode_prv = NULL,
-                    *llnode_cur = NULL;
+    // Creëer de per-PID administratie.  Die blijft de hele run bestaan.  Ook de tellers van -x
+    // worden per proces omgerekend naar de toename in het interval (zie pid-state.c).
+    if (include_churn || (extra & (PROC_EXTRA_FLT | PROC_EXTRA_CTX | PROC_EXTRA_IO)))
+        pid_state = pid_state_create(PID_STATE_INITIAL_SIZE);
 
-LOOP_THIS_BABY_FOREVER:
+    // Open /proc voor het lezen van smaps_rollup.
+    if (mem_interval > 0)
+        smaps = smaps_create();
+
+    // Creëer de administratie van de gevolgde processen voor de goedkope sample-modus.
+    if (discover_interval > 1 || include_events)
+        track = proc_track_create(extra);
+
+    // Meld ons aan voor de process-events en neem de socket op in de wacht-loop.  Dat gebeurt
+    // vóór de eerste enumeratie, zodat er geen proces tussen beide door kan glippen.
+    if (include_events && cmd_cnt > 0) {
+        events = proc_events_create();
+        tick_loop_add_fd(loop, events->fd);
+    }
 
-    // Verzamel de proc data.
+    // Creëer de sample-buffer voor de procesgegevens.  Die wordt elk interval hergebruikt.
+    PROC_SAMPLES *ps = proc_samples_create(PROC_SAMPLES_INITIAL_CAP);
+    size_t j;
+
+    // Creëer de libproc2-context éénmalig; die wordt in elk interval hergebruikt.
+    // De usernaam wordt niet door libproc2 opgezocht maar via onze eigen cache (lookup_euser()).
+    pids_items[pids_euser] = PIDS_noop;
+    // De items van -x worden alleen opgevraagd voor de gevraagde klassen.  De faults en threads
+    // staan in /proc/PID/stat, dat toch gelezen wordt.  io en ctx vragen we niet aan libproc2:
+    // procps_pids_reap() leest dan /proc/PID/io of status van elk proces op de host, vóórdat
+    // er op -c/-u gefilterd is.  Die leest proc_extra_read() alleen voor de gematchte processen.
+    if (!(extra & PROC_EXTRA_FLT))
+        pids_items[pids_minflt] = pids_items[pids_majflt] = PIDS_noop;
+    if (!(extra & PROC_EXTRA_THR))
+        pids_items[pids_nlwp] = PIDS_noop;
+    if (extra & (PROC_EXTRA_CTX | PROC_EXTRA_IO))
+        pextra = proc_extra_create();
     if (procps_pids_new(&pids_info_data, pids_items, number_of_items) < 0) {
                 fprintf(stderr, "ERROR - procps_pids_new failed\n");
                 exit(EXIT_FAILURE);
     }
 
-    // Bouw een linked list op met records uit de process table.
-    llnode_start = NULL;
-    while ((pids_stack_data = procps_pids_get(pids_info_data, include_threads ? PIDS_FETCH_THREADS_TOO : PIDS_FETCH_TASKS_ONLY))) {
-        if (cmd_cnt > 0 || uid_cnt > 0) {
-            // Voeg alleen nodes toe voor de opgegeven commando's en userid's.
-            strncpy(command, PIDS_VAL(pids_cmd, str, pids_stack_data), CMD_STRING_LEN);
-	    userid = PIDS_VAL(pids_euid, u_int, pids_stack_data);
-            if (include_record(cmd, cmd_cnt, uid, uid_cnt, uid_AND_cmd, command, userid)) {
-                add_linked_list_node(&llnode_start, &llnode_cur);
+    if (show_timing) {
+        self = &self_stats;
+        self_stats_init(self);
+    }
+
+LOOP_THIS_BABY_FOREVER:
+
+    self_stats_begin_interval(self);
+    self_stats_switch(self, PHASE_ENUM);
+
+    if (delta_mode && cmd_cnt == 0 && !group_all) {
+        // Alleen cgroups (-g): de processen hoeven niet afgelopen te worden.
+        enum_cnt = 0;
+    } else if (track && iter_cnt % discover_interval != 0 && !(events && events->lost) &&
+               sample_tracked(track, events, matcher, uid_AND_cmd, ps, &events_applied) == 0) {
+        // Goedkope meting: lees alleen /proc/PID/stat van de processen die bij de laatste
+        // volledige enumeratie gevonden zijn.  Nieuwe processen worden pas bij de volgende
+        // enumeratie (elke -D metingen) opgemerkt, of met -e via de process-events.
+        // Was er geen fd vrij, dan is de meting onvolledig en volgt hieronder een enumeratie.
+        enum_cnt = track->cnt;
+        extra_read = 0;
+    } else {
+        // De enumeratie hieronder ziet alle processen; de events tot nu toe zijn niet meer nodig.
+        if (events) {
+            proc_events_drain(events);
+            proc_events_reset(events);
+        }
+
+        // Verzamel de proc data in één bulk-fetch.
+        if ((pids_fetch_data = procps_pids_reap(pids_info_data, include_threads ? PIDS_FETCH_THREADS_TOO : PIDS_FETCH_TASKS_ONLY)) == NULL) {
+                    fprintf(stderr, "ERROR - procps_pids_reap failed\n");
+                    exit(EXIT_FAILURE);
+        }
+
+        // Vul de sample-buffer met records uit de process table.
+        enum_cnt = pids_fetch_data->counts->total;
+        proc_samples_reset(ps);
+        for (i=0; i<pids_fetch_data->counts->total; i++) {
+            pids_stack_data = pids_fetch_data->stacks[i];
+            if (cmd_cnt > 0 || uid_cnt > 0) {
+                // Voeg alleen nodes toe voor de opgegeven commando's en userid's.
+                userid = PIDS_VAL(pids_euid, u_int, pids_stack_data);
+                if (include_record(matcher, uid_AND_cmd, PIDS_VAL(pids_cmd, str, pids_stack_data), userid)) {
+                    add_proc_sample(ps);
+                }
+            } else {
+                // Er zijn geen commando's en userid's opgegeven; voeg ALLE procinfo records toe aan de sample-buffer.
+                add_proc_sample(ps);
             }
-        } else {
-            // Er zijn geen commando's en userid's opgegeven; voeg ALLE procinfo records toe aan de linked list.
-            add_linked_list_node(&llnode_start, &llnode_cur);
         }
+
+        // Onthoud de gevonden processen voor de goedkope metingen die volgen.
+        if (track)
+            proc_track_rebuild(track, ps);
+        extra_read = extra & (PROC_EXTRA_CTX | PROC_EXTRA_IO);
     }
+    iter_cnt++;
 
-    // Ruim de proc data op (alles staat nu in de linked list).
-    procps_pids_unref(&pids_info_data);
+    // Lees de klassen van -x die niet al in de enumeratie of in /proc/PID/stat zaten.
+    if (pextra && extra_read) {
+        for (j=0; j<ps->cnt; j++) {
+            proc_extra_read(pextra, ps, j, extra_read);
+        }
+    }
 
     // Initialiseer de cmd_metrics records en verzamel de socket-metrics.
-    if (delta_mode) {
-        initialize_metrics(cmd_cnt, cmd_metrics);
-        if (include_sockets) {
-            accumulate_sock_metrics(cmd, pool_ino_pp, cmd_cnt, cmd_metrics, &read_buf, &buflen);   // socket-metrics
+    self_stats_switch(self, PHASE_ACCUM);
+    if (group_all) {
+        if (grp_tab->cnt > 0)
+            initialize_metrics(grp_tab->cnt, groups);
+        if (pid_state)
+            pid_state_begin(pid_state);
+    } else if (delta_mode) {
+        initialize_metrics(col_cnt, cmd_metrics);
+        if (pid_state) {
+            pid_state_begin(pid_state);
+            memset(churn, 0, cmd_cnt * sizeof(pid_churn_t));
+        }
+        if (include_sockets && cmd_cnt > 0) {
+            accumulate_sock_metrics(matcher, sock_ino_tab, pool_ino, sock_threads, cmd_cnt, cmd_metrics, &read_buf, &buflen, &sock_scan_stats, self);   // socket-metrics
+            sock_cnt = sock_ino_tab->prev_used;
         }
     }
 
-    // Doorloop de linked list met proc data en verzamel de cmd-metrics.
+    // Doorloop de sample-buffer met proc data en verzamel de cmd-metrics.
     // Hier is een verschil tussen delta-mode=true en delta-mode=false;
     //   - delta-mode=false: de gegevens worden binnen de loop direct afgedrukt via list_procs()
-    //   - delta-mode=true:  de gegevens worden binnen de loop alleen verzameld (in cmd_metrics)
-    llnode_cur = llnode_start;
-    while (llnode_cur != NULL) {
-        if (delta_mode) {
-	    accumulate_cmd_metrics(cmd_cnt, llnode_cur, cmd_metrics);                              // cmd-metrics
-	} else {
-            list_procs(cmd, cmd_cnt, uid, uid_cnt, uid_AND_cmd, llnode_cur, first_iter, include_threads, ticks_per_sec);
+    //   - delta-mode=true:  de gegevens worden alleen verzameld (in cmd_metrics)
+    if (group_all) {
+        accumulate_group_metrics(grp_tab, &groups, &grp_cap, ps, pid_state, extra);                  // metrics per procesnaam
+        if (pid_state)
+            pid_state_sweep(pid_state, NULL);                                                       // gestopte processen vallen weg
+    } else if (delta_mode) {
+        if (cmd_cnt == 0) {
+            // alleen cgroups (-g)
+        } else if (smaps && (iter_cnt - 1) % mem_interval == 0) {
+            accumulate_cmd_metrics(cmd_cnt, matcher, ps, cmd_metrics, pid_state, churn, smaps, extra, self);    // cmd- en smaps-metrics
+        } else {
+            accumulate_cmd_metrics(cmd_cnt, matcher, ps, cmd_metrics, pid_state, churn, NULL, extra, self);     // cmd-metrics
+        }
+    } else {
+        self_stats_switch(self, PHASE_OUTPUT);
+        for (j=0; j<ps->cnt; j++) {
+            list_procs(out, ps, j, first_iter, include_threads, ticks_per_sec);
             if (unlikely(first_iter)) {
                 first_iter = false;
             }
         }
-	llnode_cur = llnode_cur->next;
     }
 
     // Indien we in delta-mode draaien hebben we nu alle gegevens verzameld in cmd_metrics.
     // Die gaan we nu afdrukken via de functie list_deltas().  Dit levert één regel op.
     // De array cmd_metrics[] bevat één record per opgegeven commando (-c).
     if (delta_mode) {
+        if (pid_state && !group_all) {
+            accumulate_churn_metrics(cmd_cnt, cmd_metrics, pid_state, churn);                      // churn-metrics
+        }
+        if (cg_cnt > 0) {
+            accumulate_cgroup_metrics(cmd_cnt, col_cnt, cmd_metrics, ticks_per_sec, first_iter);     // cgroup-metrics
+        }
+        if (include_leak) {
+            accumulate_leak_metrics(col_cnt, cmd_metrics);                                        // RSS-trend
+        }
+        self_stats_switch(self, PHASE_OUTPUT);
         current_time(time_string);
-        list_deltas(cmd_cnt, cmd_metrics, time_string, ticks_per_sec, loop_interval, heading_interval, include_sockets, first_iter, &line_cnt);
+        if (group_all) {
+            if (rank_cap < grp_cap) {
+                if ((grp_rank = realloc(grp_rank, grp_cap * sizeof(CMD_METRICS *))) == NULL) {
+                    fprintf(stderr, "ERROR: realloc() of the group ranking failed: %d (%s)\n", errno, strerror(errno));
+                    exit(EXIT_FAILURE);
+                }
+                rank_cap = grp_cap;
+            }
+            top_cnt = select_top_groups(grp_tab->cnt, groups, grp_rank, top_n, top);
+            list_top(out, top_cnt, top, time_string, ticks_per_sec, loop_interval, heading_interval, extra, first_iter, &line_cnt);
+        } else {
+            list_deltas(out, col_cnt, cmd_metrics, time_string, ticks_per_sec, loop_interval, heading_interval, include_sockets, include_churn, mem_interval > 0, include_leak, extra, first_iter, &line_cnt);
+        }
+        if (ring) {
+            // De records worden rechtstreeks in het gemapte bestand gevuld (zie ring-out.h).
+            fill_cmd_recs(ring_out_begin(ring), col_cnt, cmd_metrics);
+            ring_out_commit(ring, sample_time_ns());
+        }
+        if (prom) {
+            // Eén render per interval; de scrapers krijgen daarna allemaal dezelfde buffer.
+            fill_cmd_recs(prom_recs, col_cnt, cmd_metrics);
+            prom_render(prom, col_cnt, col_name, prom_recs, ticks_per_sec, out_flags, sample_time_ns());
+        }
         if (unlikely(first_iter)) {
             first_iter = false;
         }
     }
 
-    // Ruim de linked list op.
-    destroy_linked_list(llnode_start);
+    // Schrijf de output van dit interval weg.
+    out_flush(out);
+    self_stats_end(self);
 
-    // Handel de signals af.
-    if (loop_interval > 0) {
-        // Block het programma totdat de itimer afloopt en we een SIGALRM ontvangen.
-        pause();
-	if (shouldStop) {
-            // We hebben een SIGTERM ontvangen.  Flush en stop.
-            fflush(stdout);
-        } else {
+    if (show_timing) {
+        // De kosten van de collector zelf: tellingen en doorlooptijden per fase.
+        fprintf(stderr, "proc-sample: %ld of %ld procs, capacity: %ld, allocations: %lu\n", ps->cnt, enum_cnt, ps->cap, ps->alloc_cnt);
+        if (track) {
+            fprintf(stderr, "proc-track: %ld tracked, %lu gone since discovery, fds kept: %ld of %ld, fd shortages: %lu\n",
+                    track->cnt, track->gone, track->fd_kept, track->fd_budget, track->fd_fail);
+        }
+        if (grp_tab) {
+            fprintf(stderr, "cmd-group: %d groups, %d shown\n", grp_tab->cnt, top_cnt);
+        }
+        if (events) {
+            fprintf(stderr, "proc-events: %lu received, %lu applied, %lu added, lost: %lu times\n",
+                    events->total, events_applied, track->added, events->lost_cnt);
+        }
+        if (include_sockets && delta_mode) {
+            sock_scan_stats_print(stderr, &sock_scan_stats);
+            fprintf(stderr, "pool-ino: %lu sockets hashed, size: %zu, high-water: %zu, extends: %lu\n", sock_cnt,
+                    pool_size(pool_ino), pool_high_water(pool_ino), pool_extend_count(pool_ino));
+        }
+        if (pextra) {
+            fprintf(stderr, "proc-extra: read: %lu, failed: %lu (since start)\n", pextra->read_cnt, pextra->fail_cnt);
+        }
+        if (smaps) {
+            fprintf(stderr, "smaps: read: %lu, failed: %lu (since start)\n", smaps->read_cnt, smaps->fail_cnt);
+        }
+        if (prom) {
+            fprintf(stderr, "prom: %lu scrapes\n", prom->scrapes);
+        }
+        self_stats_print(stderr, self);
+    }
+
+    // Wacht op het volgende interval en handel intussen de signals en de scrapers af.
+    if (loop) {
+        while (!shouldStop) {
+            loop_ev = tick_loop_wait(loop, prom ? prom_timeout_ms(prom) : -1, &signo);
+            if (loop_ev == TICK_EV_TICK)
+                break;
+            if (loop_ev == TICK_EV_SIGNAL) {
+                if (signo == SIGHUP)
+                    shouldReopenStdout = true;
+                else
+                    shouldStop = true;    // SIGTERM of SIGINT
+            }
             if (shouldReopenStdout) {
                 // We hebben een SIGHUP ontvangen, vermoedelijk vanwege een logfile-rotation.
                 // Reopen stdout.  De variabele stdout_path bevat de volledige naam van de file die
@@ -706,10 +1537,71 @@ LOOP_THIS_BABY_FOREVER:
 		    fprintf(stderr, "WARNING: freopen of %s failed: %d (%s)\n", stdout_path, errno, strerror(errno));
 		}
             }
+            if (prom) {
+                prom_serve(prom);
+            }
+            if (events) {
+                // Haal de events tussendoor op, zodat de ontvangstbuffer niet volloopt.
+                proc_events_drain(events);
+            }
+        }
+	if (shouldStop) {
+            // We hebben een SIGTERM ontvangen.  Flush en stop.
+            fflush(stdout);
+        } else {
+            // De delta's van de volgende meting beslaan meer dan één interval als er intervallen
+            // overgeslagen zijn; meld dat, zodat de cijfers niet ongemerkt als één interval gelezen worden.
+            if (loop->missed_last > 0) {
+                fprintf(stderr, "WARNING: %lu interval(s) skipped, the previous sample took too long\n", loop->missed_last);
+            }
+            if (show_timing) {
+                fprintf(stderr, "tick: %lu, late: %lld us, max: %lld us, avg: %.0f us, skipped: %lu\n", loop->ticks,
+                        loop->late_ns / 1000, loop->late_max_ns / 1000, loop->late_sum_ns / loop->ticks / 1000, loop->missed);
+            }
             // GOTO's zijn niet altijd slecht.
             goto LOOP_THIS_BABY_FOREVER;
         }
     }
 
+    // Ruim de libproc2-context, de sample-buffer en de socket-administratie op.
+    procps_pids_unref(&pids_info_data);
+    proc_samples_destroy(ps);
+    if (track)
+        proc_track_destroy(track);
+    if (events)
+        proc_events_destroy(events);
+    if (grp_tab) {
+        cmd_group_destroy(grp_tab);
+        free(groups);
+        free(grp_rank);
+        free(top);
+    }
+    if (smaps)
+        smaps_destroy(smaps);
+    if (pextra)
+        proc_extra_destroy(pextra);
+    if (ring)
+        ring_close(ring);
+    out_destroy(out);
+    if (include_leak) {
+        for (i=0; i<col_cnt; i++) {
+            leak_est_free(&cmd_metrics[i].leak);
+        }
+    }
+    for (i=cmd_cnt; i<col_cnt; i++) {
+        cgroup_destroy(cmd_metrics[i].cgroup);
+    }
+    if (prom) {
+        prom_destroy(prom);
+        free(prom_recs);
+    }
+    if (loop)
+        tick_loop_destroy(loop);
+    if (sock_ino_tab) {
+        sock_ino_par_stop();
+        sock_ino_tab_destroy(sock_ino_tab);
+        pool_destroy(pool_ino);
+    }
+
     exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Microbenchmark voor de socket-inode hash-table.
+ *
+ * Vergelijkt de doorvoer van opbouw en lookups van de open-addressing tabel uit
+ * inode-stats.c met die van de oude chained hash-table (vaste bucket-array met
+ * XOR-folding hashfunctie), met 256 buckets (het origineel) en met 65536 buckets.
+ *
+ * Gebruik: ./ino-bench [aantal sockets] [aantal lookups]
+ *
+ * De inode-nummers worden gegenereerd zoals de kernel ze uitdeelt: oplopend met
+ * kleine gaten.  Van de lookups is 90% een treffer, zoals bij de fd-scan waar ook
+ * sockets langskomen die niet in de tabel staan (bv. netlink-sockets).
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mempool.h"
+#include "cmd-match.h"
+#include "inode-stats.h"
+
+#define BENCH_SOCKETS 200000
+#define BENCH_LOOKUPS 1000000
+
+// De oude chained hash-table, als referentie.
+struct chain_ent {
+	struct chain_ent *next;
+	unsigned int      ino;
+	unsigned int      state;
+};
+
+static int chain_hashfn(unsigned int ino, int size) {
+	int val = (ino >> 24) ^ (ino >> 16) ^ (ino >> 8) ^ ino;
+
+	return val & (size - 1);
+}
+
+static double elapsed(struct timespec *t0, struct timespec *t1) {
+	return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static void bench_chained(int buckets, unsigned int *inos, long n, unsigned int *lookups, long m) {
+	struct chain_ent **hash = calloc(buckets, sizeof(struct chain_ent *));
+	struct chain_ent *ents = malloc(n * sizeof(struct chain_ent));
+	struct timespec t0, t1, t2;
+	unsigned long found = 0;
+	struct chain_ent *p;
+	int h;
+
+	if (!hash || !ents) {
+		printf("ERROR - malloc failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (long i=0; i<n; i++) {
+		h = chain_hashfn(inos[i], buckets);
+		ents[i].ino   = inos[i];
+		ents[i].state = 1;
+		ents[i].next  = hash[h];
+		hash[h] = &ents[i];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (long i=0; i<m; i++) {
+		p = hash[chain_hashfn(lookups[i], buckets)];
+		while (p && p->ino != lookups[i])
+			p = p->next;
+		if (p)
+			found += p->state;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	printf("chained %6d buckets   build: %8.2f ms  lookup: %8.2f Mlookups/s  (found %lu)\n", buckets,
+	       elapsed(&t0, &t1) * 1000, m / elapsed(&t1, &t2) / 1e6, found);
+	free(ents);
+	free(hash);
+}
+
+static void bench_open(unsigned int *inos, long n, unsigned int *lookups, long m, int rounds) {
+	sock_ino_tab_t *tab = sock_ino_tab_create();
+	POOL *pool_ino = pool_create(1024*1024);
+	struct timespec t0, t1, t2;
+	unsigned long found = 0;
+	sock_ino_ent_t *p;
+
+	// De eerste ronde groeit de tabel vanaf de minimale grootte.  De volgende ronden
+	// zijn gedimensioneerd op de vorige ronde, zoals van interval tot interval.
+	for (int r=0; r<rounds; r++) {
+		found = 0;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if (r > 0) {
+			sock_ino_destroy_hash_table(tab, pool_ino);
+		}
+		for (long i=0; i<n; i++) {
+			sock_ino_add(tab, pool_ino, inos[i], 0, 0, 0, 0, 0, 1, SOCK_FAM_TCP);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		for (long i=0; i<m; i++) {
+			if ((p = sock_ino_find(tab, lookups[i])) != NULL)
+				found += p->state;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		printf("open addressing %-7s build: %8.2f ms  lookup: %8.2f Mlookups/s  (found %lu, slots %lu)\n",
+		       r == 0 ? "(cold)" : "(warm)",
+		       elapsed(&t0, &t1) * 1000, m / elapsed(&t1, &t2) / 1e6, found, tab->size);
+	}
+	sock_ino_tab_destroy(tab);
+	pool_destroy(pool_ino);
+}
+
+int main(int argc, char **argv) {
+	long n = argc > 1 ? atol(argv[1]) : BENCH_SOCKETS;
+	long m = argc > 2 ? atol(argv[2]) : BENCH_LOOKUPS;
+	unsigned int *inos, *lookups;
+	unsigned int ino;
+
+	if (n <= 0 || m <= 0) {
+		fprintf(stderr, "usage: %s [sockets] [lookups]\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	inos    = malloc(n * sizeof(unsigned int));
+	lookups = malloc(m * sizeof(unsigned int));
+	if (!inos || !lookups) {
+		printf("ERROR - malloc failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	srand(42);
+	ino = 1000000 + rand() % 1000;
+	for (long i=0; i<n; i++) {
+		ino += 1 + rand() % 4;
+		inos[i] = ino;
+	}
+	for (long i=0; i<m; i++) {
+		if (rand() % 10)
+			lookups[i] = inos[rand() % n];
+		else
+			lookups[i] = ino + 1 + rand() % 1000000;   // misser
+	}
+
+	printf("sockets: %ld, lookups: %ld\n", n, m);
+	bench_chained(256, inos, n, lookups, m);
+	bench_chained(65536, inos, n, lookups, m);
+	bench_open(inos, n, lookups, m, 2);
+
+	free(inos);
+	free(lookups);
+	exit(EXIT_SUCCESS);
+}
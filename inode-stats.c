@@ -25,140 +25,292 @@
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#define _GNU_SOURCE    // voor O_PATH
 #include <errno.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
-#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/unix_diag.h>
 #include "mempool.h"
+#include "cmd-match.h"
 #include "inode-stats.h"
 
-void read_proc_file(char *fname, char **buf, long *size) {
-	FILE *fd;
-	char *newptr;
-	long read;
+// Directory-entry zoals getdents64 hem oplevert (zie getdents(2)).
+struct linux_dirent64 {
+	unsigned long long d_ino;
+	long long          d_off;
+	unsigned short     d_reclen;
+	unsigned char      d_type;
+	char               d_name[];
+};
 
-	if (*buf == NULL) {
-		if ((*buf = malloc(*size + 1)) == NULL) {
-			printf("ERROR - malloc(%ld) failed, %d - %s\n", *size, errno, strerror(errno));
-			exit(EXIT_FAILURE);
-		}
+// Leesstatus van een directory die via getdents64 wordt doorlopen.
+typedef struct ino_dents {
+	int   fd;
+	char *buf;
+	long  len;
+	long  pos;
+} ino_dents_t;
+
+// Administratie van de multithreaded scan (zie ino_par_run()).
+typedef struct ino_par_job {               // één gematcht proces
+	int    pid;                        // de workers lezen <pid>/fd/<fd> relatief aan /proc/
+	size_t match_off;                  // indexen van de gematchte commando's in ino_par_t.match
+	int    match_cnt;
+} ino_par_job_t;
+
+typedef struct ino_par_item {              // één fd van een gematcht proces
+	int job;
+	int fd;
+} ino_par_item_t;
+
+typedef struct ino_par_worker ino_par_worker_t;
+
+typedef struct ino_par {
+	sock_ino_tab_t *tab;
+	int             proc_fd;           // open /proc/ tijdens de scan
+	ino_par_job_t  *jobs;
+	size_t          job_cnt, job_cap;
+	int            *match;
+	size_t          match_cnt, match_cap;
+	ino_par_item_t *items;
+	size_t          item_cnt, item_cap;
+	size_t          next;              // eerste fd die nog niet door een worker is opgepakt
+	// De workers worden éénmalig gestart (sock_ino_par_start()) en wachten tussen de
+	// scans op een nieuwe generatie.
+	ino_par_worker_t *w;
+	int             threads;           // aantal workers, inclusief de aanroepende thread
+	sock_aggr_t    *aggr;              // aggregatie per worker per commando
+	size_t          aggr_cap;
+	pthread_mutex_t lock;
+	pthread_cond_t  start;             // nieuwe generatie (of stop)
+	pthread_cond_t  done;              // busy is 0 geworden
+	unsigned long   gen;
+	int             busy;              // aantal workers dat nog bezig is met deze generatie
+	int             stop;
+} ino_par_t;
+
+struct ino_par_worker {
+	ino_par_t     *par;
+	sock_aggr_t   *s;                  // eigen aggregatie per commando
+	unsigned long  sockets_found;
+	pthread_t      tid;
+};
+
+#define INO_PAR_CHUNK       256            // aantal fd's dat een worker per keer oppakt
+#define INO_PAR_INITIAL_CAP 1024
+
+#define SOCK_DIAG_ALL_STATES   0xffffffff
+#define SOCK_DIAG_NEW_SYN_RECV 12         // TCP_NEW_SYN_RECV uit de kernel (niet in netinet/tcp.h)
+
+// Decodeer-tabel voor hex-cijfers: de waarde van het cijfer, of 0xff voor elk ander teken
+// (ook '\0' en '\n'), zodat de decodeer-loops met één vergelijking per teken toe kunnen.
+static unsigned char ino_hex_val[256];
+static int ino_hex_ready = 0;
+
+static void ino_hex_init(void) {
+	ino_hex_ready = 1;
+	memset(ino_hex_val, 0xff, sizeof(ino_hex_val));
+	for (int i=0; i<10; i++)
+		ino_hex_val['0' + i] = i;
+	for (int i=0; i<6; i++)
+		ino_hex_val['a' + i] = ino_hex_val['A' + i] = 10 + i;
+}
+
+static inline const char * ino_skip_ws(const char *p) {
+	while (*p == ' ' || *p == '\t')
+		p++;
+	return p;
+}
+
+static inline const char * ino_skip_token(const char *p) {
+	while (*p != ' ' && *p != '\t' && *p != '\0')
+		p++;
+	return p;
+}
+
+// Lees een hex-getal van maximaal <max> cijfers (zoals "%<max>x" van sscanf).
+// Geeft NULL terug wanneer er geen cijfer staat.
+static inline const char * ino_parse_hex(const char *p, int max, unsigned int *val) {
+	unsigned int v = 0, d;
+	const char *start = p;
+
+	while (p - start < max && (d = ino_hex_val[(unsigned char) *p]) < 16) {
+		v = (v << 4) | d;
+		p++;
 	}
-	while (1) {
-		if ((fd = fopen(fname, "r")) == NULL) {
-			printf("ERROR - fopen(%s, \"r\") failed, %d - %s\n", fname, errno, strerror(errno));
-			exit(EXIT_FAILURE);
-		}
-		read = fread(*buf, sizeof(char), *size, fd);
-		memset(*buf + read, 0, 1);
-		if (feof(fd)) {
-			// De data past in de buffer.
-			fclose(fd);
-			return;
-		} else {
-			// De data paste niet in de buffer.
-			// We willen de complete file in een enkele buffer hebben.
-			// Maak de buffer 2x zo groot en probeer opnieuw.
-			fclose(fd);
-			*size *= 2;
-			newptr = realloc(*buf, *size + 1);
-			if (newptr) {
-				*buf = newptr;
-			} else {
-				printf("ERROR - realloc(%ld) failed, %d - %s\n", *size + 1, errno, strerror(errno));
-				exit(EXIT_FAILURE);
-			}
-		}
+	*val = v;
+	return p == start ? NULL : p;
+}
+
+// Lees een decimaal getal (zoals "%u" van sscanf, zonder teken).
+static inline const char * ino_parse_dec(const char *p, unsigned int *val) {
+	unsigned int v = 0;
+	const char *start = p;
+
+	while ((unsigned) (*p - '0') < 10)
+		v = v * 10 + (*p++ - '0');
+	*val = v;
+	return p == start ? NULL : p;
+}
+
+// Lees "<hex>:<hex>" (adres:poort, tx:rx, enz.), voorafgegaan door witruimte.
+static inline const char * ino_parse_pair(const char *p, int max1, unsigned int *v1, int max2, unsigned int *v2) {
+	p = ino_parse_hex(ino_skip_ws(p), max1, v1);
+	if (p == NULL || *p != ':')
+		return NULL;
+	return ino_parse_hex(p + 1, max2, v2);
+}
+
+// Ontleed één regel van /proc/net/{tcp,tcp6,udp,udp6,unix}, met hetzelfde resultaat als de
+// sscanf-formaten die hier eerder gebruikt werden:
+//   tcp/udp:   " %*s %8x:%4x %8x:%4x %2x %*8x:%*8x %*2x:%*8x %*8x %u %*d %u "
+//   tcp6/udp6: " %*s %*32[0-9A-Fa-f]:%4x %*32[0-9A-Fa-f]:%4x %2x %*8x:%*8x %*2x:%*8x %*8x %u %*d %u "
+//   unix:      "%*s %*x %*x %x %x %x %u"
+// De regel is afgesloten met een '\0'.  Geeft het inode-nummer terug, of 0 wanneer de regel
+// niet (volledig) te ontleden is; zulke regels werden ook met sscanf overgeslagen.
+static unsigned int ino_parse_line(const char *p, unsigned int family, unsigned int *uid,
+                                   unsigned int *addr_loc, unsigned int *port_loc,
+                                   unsigned int *addr_rem, unsigned int *port_rem, unsigned int *state) {
+	unsigned int dummy, flags, type, ino;
+
+	p = ino_skip_token(ino_skip_ws(p));          // sl, resp. Num
+	if (family == SOCK_FAM_UNIX) {
+		*uid = 0;
+		if ((p = ino_parse_hex(ino_skip_ws(p), 8, &dummy)) == NULL ||      // RefCount
+		    (p = ino_parse_hex(ino_skip_ws(p), 8, &dummy)) == NULL ||      // Protocol
+		    (p = ino_parse_hex(ino_skip_ws(p), 8, &flags)) == NULL ||
+		    (p = ino_parse_hex(ino_skip_ws(p), 8, &type)) == NULL ||
+		    (p = ino_parse_hex(ino_skip_ws(p), 8, state)) == NULL ||
+		    (p = ino_parse_dec(ino_skip_ws(p), &ino)) == NULL)
+			return 0;
+		return ino;
 	}
+	if (family == SOCK_FAM_TCP6 || family == SOCK_FAM_UDP6) {
+		// Van IPv6-sockets worden de adressen niet bewaard.
+		if ((p = ino_parse_pair(p, 32, &dummy, 4, port_loc)) == NULL ||
+		    (p = ino_parse_pair(p, 32, &dummy, 4, port_rem)) == NULL)
+			return 0;
+	} else {
+		if ((p = ino_parse_pair(p, 8, addr_loc, 4, port_loc)) == NULL ||
+		    (p = ino_parse_pair(p, 8, addr_rem, 4, port_rem)) == NULL)
+			return 0;
+	}
+	if ((p = ino_parse_hex(ino_skip_ws(p), 2, state)) == NULL ||
+	    (p = ino_parse_pair(p, 8, &dummy, 8, &dummy)) == NULL ||          // tx_queue:rx_queue
+	    (p = ino_parse_pair(p, 2, &dummy, 8, &dummy)) == NULL ||          // tr:tm->when
+	    (p = ino_parse_hex(ino_skip_ws(p), 8, &dummy)) == NULL ||         // retrnsmt
+	    (p = ino_parse_dec(ino_skip_ws(p), uid)) == NULL)
+		return 0;
+	p = ino_skip_ws(p);                                                   // timeout (%d)
+	if (*p == '-' || *p == '+')
+		p++;
+	if ((p = ino_parse_dec(p, &dummy)) == NULL ||
+	    (p = ino_parse_dec(ino_skip_ws(p), &ino)) == NULL)
+		return 0;
+	return ino;
 }
 
-int ino_hashfn(unsigned int ino) {
-	int val = (ino >> 24) ^ (ino >> 16) ^ (ino >> 8) ^ ino;
+unsigned long ino_hashfn(unsigned int ino, unsigned long mask) {
+	// Inode-nummers van sockets liggen dicht bij elkaar en zijn vaak opeenvolgend.
+	// Bij linear probing levert dat lange aaneengesloten clusters op, dus we mixen
+	// alle bits door elkaar (de finalizer van MurmurHash3).
+	ino ^= ino >> 16;
+	ino *= 0x85ebca6b;
+	ino ^= ino >> 13;
+	ino *= 0xc2b2ae35;
+	ino ^= ino >> 16;
 
-	return val & (INO_HASH_SIZE - 1);
+	return ino & mask;
 }
 
-void sock_ino_traverse_hash_table(sock_ino_ent_t *hash_array[INO_HASH_SIZE]) {
-	sock_ino_ent_t *p;
+sock_ino_tab_t * sock_ino_tab_create(void) {
+	sock_ino_tab_t *tab;
 
-	for (int i=0; i<INO_HASH_SIZE; i++) {
-		printf("sock_ino_traverse_hash_table() - hash_array[%d] points at %p\n", i, hash_array[i]);
-		if (hash_array[i]) {
-			p = hash_array[i];
-			while (p) {
-				printf("sock_ino_traverse_hash_table()       p->ino==%d, p->uid==%d, p->next==%p\n", p->ino, p->uid, p->next);
-				p = p->next;
-			}
+	if ((tab = calloc(1, sizeof(sock_ino_tab_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(sock_ino_tab_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return tab;
+}
+
+void sock_ino_tab_destroy(sock_ino_tab_t *tab) {
+	free(tab->slots);
+	free(tab);
+}
+
+// (Her)alloceer de slots-array met <size> slots, en plaats de bestaande entries opnieuw.
+static void sock_ino_tab_resize(sock_ino_tab_t *tab, unsigned long size) {
+	sock_ino_slot_t *old_slots = tab->slots;
+	unsigned long old_size = tab->size;
+	unsigned long h;
+
+	if ((tab->slots = calloc(size, sizeof(sock_ino_slot_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", size * sizeof(sock_ino_slot_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	tab->size = size;
+	for (unsigned long i=0; i<old_size; i++) {
+		if (old_slots[i].ino) {
+			h = ino_hashfn(old_slots[i].ino, size - 1);
+			while (tab->slots[h].ino)
+				h = (h + 1) & (size - 1);
+			tab->slots[h] = old_slots[i];
 		}
 	}
+	free(old_slots);
 }
 
-void sock_ino_fix_pointers(POOL *pool_ino_old, POOL *pool_ino_new, sock_ino_ent_t *hash_array[INO_HASH_SIZE]) {
-	signed long long pool_ino_offset;
-	sock_ino_ent_t *p;
-	char *pool_ino_old_c, *pool_ino_new_c;
-	char *p_c;
-
-	pool_ino_old_c = (char *) pool_ino_old;
-	pool_ino_new_c = (char *) pool_ino_new;
-	pool_ino_offset = pool_ino_new_c - pool_ino_old_c;
-//	printf("sock_ino_fix_pointers(%p, %p, %p) - pool_ino_offset: %lld\n", pool_ino_old, pool_ino_new, hash_array, pool_ino_offset);
-	if (pool_ino_offset) {
-		// de realloc() call heeft de memory-pool verplaatst naar een nieuwe locatie.
-		// alle bestaande pointers naar de memory-pool moeten gefixt worden.
-		for (int i=0; i<INO_HASH_SIZE; i++) {
-			if (hash_array[i]) {
-				p_c = (char *) hash_array[i] + pool_ino_offset;
-				p = (sock_ino_ent_t *) p_c;
-//				printf("sock_ino_fix_pointers() - entering while-loop for hash_array[%d] old p==%p, new p==%p, p_c==%p, p->next==%p\n", i, hash_array[i], p, p_c, p->next);
-				hash_array[i] = p;
-				while (p) {
-					if (p->next) {
-						p_c = (char *) p->next + pool_ino_offset;
-						p->next = (sock_ino_ent_t *) p_c;
-//						printf("sock_ino_fix_pointers() - for p (%p) fixed p->next to %p\n", p, p->next);
-					}
-//					printf("sock_ino_fix_pointers() - p->next==%p, p->ino==%d, p->uid==%d\n", p->next, p->ino, p->uid);
-					p = p->next;
-//					printf("sock_ino_fix_pointers() - at end of while-block, p == %p\n", p);
-				}
-			}
+void sock_ino_traverse_hash_table(sock_ino_tab_t *tab) {
+	for (unsigned long i=0; i<tab->size; i++) {
+		if (tab->slots[i].ino) {
+			printf("sock_ino_traverse_hash_table() - slot[%ld] ino==%d, ent==%p, home==%ld\n", i,
+			       tab->slots[i].ino, tab->slots[i].ent, ino_hashfn(tab->slots[i].ino, tab->size - 1));
 		}
 	}
 }
 
-void sock_ino_add(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL **pool_ino,
-                      unsigned int ino, unsigned int uid,
-                      unsigned int addr_loc, unsigned int port_loc,
-                      unsigned int addr_rem, unsigned int port_rem,
-		      unsigned int state) {
-	sock_ino_ent_t *p, *p2;
-	POOL *pool_ino_old = *pool_ino;
-	POOL *pool_ino_new = *pool_ino;
+void sock_ino_add(sock_ino_tab_t *tab, POOL *pool_ino,
+                  unsigned int ino, unsigned int uid,
+                  unsigned int addr_loc, unsigned int port_loc,
+                  unsigned int addr_rem, unsigned int port_rem,
+                  unsigned int state, unsigned int family) {
+	sock_ino_ent_t *p;
+	unsigned long h;
+
+	// Houd de bezettingsgraad onder de 50%, zodat de probe-reeksen kort blijven.
+	if ((tab->used + 1) * 2 > tab->size)
+		sock_ino_tab_resize(tab, tab->size ? tab->size * 2 : INO_TAB_MIN_SIZE);
+
+	// Zoek het slot op.  Een inode die al in de tabel staat (bv. dubbel gerapporteerd)
+	// wordt overschreven in plaats van nogmaals toegevoegd.
+	h = ino_hashfn(ino, tab->size - 1);
+	while (tab->slots[h].ino && tab->slots[h].ino != ino)
+		h = (h + 1) & (tab->size - 1);
+	p = tab->slots[h].ent;
 
-	// Maak een nieuwe node aan
-	p = pool_alloc(*pool_ino, (sizeof(sock_ino_ent_t)));
+	// Maak zo nodig een nieuwe node aan.  De pool groeit zelf bij (zonder de bestaande
+	// nodes te verplaatsen), dus de pointers in de slots blijven geldig.
 	if (!p) {
-//		sock_ino_traverse_hash_table(hash_array);
-		if ((*pool_ino = pool_extend(*pool_ino)) == NULL) {
-			printf("ERROR - failed pool_extend() in sock_ino_add()\n");
-			exit(EXIT_FAILURE);
-		} else {
-			pool_ino_new = *pool_ino;
-			sock_ino_fix_pointers(pool_ino_old, pool_ino_new, hash_array);
-	
-			if ((p = pool_alloc(*pool_ino, sizeof(sock_ino_ent_t))) == NULL) {
-				printf("ERROR - failed pool_alloc sock_ino_ent_t (%ld bytes)\n", sizeof(sock_ino_ent_t));
-				exit(EXIT_FAILURE);
-			}
-		}
+		p = pool_alloc(pool_ino, sizeof(sock_ino_ent_t));
+		tab->slots[h].ino = ino;
+		tab->slots[h].ent = p;
+		tab->used++;
 	}
 
 	// Vul de node met gegevens
-	p->next     = NULL;
 	p->ino      = ino;
 	p->uid      = uid;
 	p->addr_loc = addr_loc;
@@ -166,240 +318,760 @@ void sock_ino_add(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL **pool_ino,
 	p->addr_rem = addr_rem;
 	p->port_rem = port_rem;
 	p->state    = state;
-
-	// Hang de reeds bestaande linked list (=de hash-bucket) aan p->next
-	p->next = hash_array[ino_hashfn(ino)];
-
-	// Wijs het adres van de nieuwe node toe aan de hash-bucket
-	hash_array[ino_hashfn(ino)] = p;
+	p->family   = family;
 }
 
-sock_ino_ent_t * sock_ino_find(sock_ino_ent_t *hash_array[INO_HASH_SIZE], unsigned int ino) {
-	sock_ino_ent_t *p;
-	int cnt = 0;
+sock_ino_ent_t * sock_ino_find(sock_ino_tab_t *tab, unsigned int ino) {
+	unsigned long h;
 
 	// Wanneer het inode-nummer 0 is, skippen we hem.
 	// Alle inodes in de status TIME_WAIT krijgen namelijk inode-nummer 0 toebedeeld,
 	// want die zijn niet meer gekoppeld aan een owner (een proces).
-	if (!ino)
+	if (!ino || !tab->used)
 		return NULL;
 
-	// Selecteer de hash-bucket voor deze inode
-	p = hash_array[ino_hashfn(ino)];
-
-	// Scan de hash-bucket
-	while (p && cnt==0) {             // inode-nummers zijn uniek, dus we stoppen na een match
-		if (p->ino == ino) {
-			cnt++;
-		} else {
-			p = p->next;
-		}
+	// Probe vanaf het thuis-slot tot de inode of een leeg slot gevonden is.
+	// inode-nummers zijn uniek, dus we stoppen na een match.
+	h = ino_hashfn(ino, tab->size - 1);
+	while (tab->slots[h].ino) {
+		if (tab->slots[h].ino == ino)
+			return tab->slots[h].ent;
+		h = (h + 1) & (tab->size - 1);
 	}
-	return p;
+	return NULL;
 }
 
 void sock_ino_print(sock_ino_ent_t *p, int pid) {
+	static const char *family_name[SOCK_FAM_CNT] = {"tcp", "tcp6", "udp", "udp6", "unix"};
 	char addr_loc_str[INET_ADDRSTRLEN], addr_rem_str[INET_ADDRSTRLEN];
 
-	inet_ntop(AF_INET, &p->addr_loc, addr_loc_str, INET_ADDRSTRLEN);
-	inet_ntop(AF_INET, &p->addr_rem, addr_rem_str, INET_ADDRSTRLEN);
-	printf("Found pid: %5d ino: %9d uid: %d local addr: %15s:%-5d remote addr: %15s:%-5d state: %2d\n",
-		pid, p->ino, p->uid,
+	// Alleen van IPv4-sockets worden de adressen bewaard (zie sock_ino_build_from_proc()).
+	if (p->family == SOCK_FAM_TCP || p->family == SOCK_FAM_UDP) {
+		inet_ntop(AF_INET, &p->addr_loc, addr_loc_str, INET_ADDRSTRLEN);
+		inet_ntop(AF_INET, &p->addr_rem, addr_rem_str, INET_ADDRSTRLEN);
+	} else {
+		strcpy(addr_loc_str, "-");
+		strcpy(addr_rem_str, "-");
+	}
+	printf("Found pid: %5d ino: %9d uid: %d %-4s local addr: %15s:%-5d remote addr: %15s:%-5d state: %2d\n",
+		pid, p->ino, p->uid, family_name[p->family],
 		addr_loc_str, p->port_loc,
 		addr_rem_str, p->port_rem, p->state);
 }
 
 void sock_aggr_print(sock_aggr_t *s) {
-	printf("cnt: %5ld established: %5ld close_wait: %5ld listen: %5ld rest: %5ld\n", s->sock_total,
-	        s->state.established, s->state.close_wait, s->state.listener, s->state.rest);
+	printf("cnt: %5ld established: %5ld close_wait: %5ld listen: %5ld rest: %5ld tcp: %5ld tcp6: %5ld udp: %5ld udp6: %5ld unix: %5ld\n", s->sock_total,
+	        s->state.established, s->state.close_wait, s->state.listener, s->state.rest,
+	        s->family.tcp, s->family.tcp6, s->family.udp, s->family.udp6, s->family.unix_domain);
 }
 
-void sock_ino_build_hash_table(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL **pool_ino, char **read_buf, long *buflen) {
-	char *net = getenv("PROC_TCP") ? : "/proc/net/tcp";
-	unsigned int addr_loc, port_loc, addr_rem, port_rem, state, uid, ino;
-	int matchcnt;
+// Neem één regel van /proc/net/* op in de hash-table.
+static inline void sock_ino_add_line(sock_ino_tab_t *tab, POOL *pool_ino, const char *line, unsigned int family) {
+	unsigned int addr_loc = 0, port_loc = 0, addr_rem = 0, port_rem = 0, state, uid, ino;
+
+	ino = ino_parse_line(line, family, &uid, &addr_loc, &port_loc, &addr_rem, &port_rem, &state);
+	// Sockets met inode number 0 zijn niet owned door een proces,
+	// dus die hoeven we niet op te nemen in de hash table.
+	if (ino) {
+		sock_ino_add(tab, pool_ino, ino, uid, addr_loc, port_loc, addr_rem, port_rem, state, family);
+	}
+}
+
+// Bouw de hash-table op uit de tekst van /proc/net/{tcp,tcp6,udp,udp6,unix} (de fallback voor sock_diag).
+// Het bestand wordt in blokken van de grootte van de read-buffer gelezen en regel voor regel
+// verwerkt; een regel die over de grens van een blok heen loopt wordt naar het begin van de
+// buffer geschoven en met het volgende blok aangevuld.  Zo wordt het bestand maar één keer
+// gelezen, hoe groot het ook is (voorheen werd het bij een te kleine buffer opnieuw gelezen).
+// Van IPv6-sockets worden de adressen niet bewaard; voor de tellingen zijn alleen
+// het inode-nummer, de familie en de state nodig.
+// Geeft 0 terug bij succes en -1 wanneer het bestand niet te openen is.
+int sock_ino_build_from_proc(sock_ino_tab_t *tab, POOL *pool_ino, char **read_buf, long *buflen,
+                             const char *net, unsigned int family) {
+	char *line, *nl, *end, *newptr;
+	long have = 0;                    // bytes in de buffer die nog niet verwerkt zijn
+	int header = 1;                   // de eerste regel is de kopregel
+	ssize_t len;
+	int fd;
+
+	if (!ino_hex_ready)
+		ino_hex_init();
+	if (*read_buf == NULL) {
+		if ((*read_buf = malloc(*buflen + 1)) == NULL) {
+			printf("ERROR - malloc(%ld) failed, %d - %s\n", *buflen, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((fd = open(net, O_RDONLY | O_CLOEXEC)) == -1) {
+		// De aanroeper beslist of dit fataal is (bv. /proc/net/tcp6 ontbreekt zonder IPv6).
+		return -1;
+	}
+
+	while (1) {
+		len = read(fd, *read_buf + have, *buflen - have);
+		if (len == -1 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			break;
+		end  = *read_buf + have + len;
+		line = *read_buf;
+		// memchr() zoekt in glibc met SIMD-instructies naar de '\n'.
+		while ((nl = memchr(line, '\n', end - line)) != NULL) {
+			*nl = '\0';
+			if (header)
+				header = 0;
+			else
+				sock_ino_add_line(tab, pool_ino, line, family);
+			line = nl + 1;
+		}
+		// Schuif de onvolledige regel naar het begin van de buffer.  Past één regel niet in
+		// de buffer (in de praktijk nooit), dan wordt de buffer vergroot.
+		have = end - line;
+		if (have > 0 && line != *read_buf)
+			memmove(*read_buf, line, have);
+		if (have == *buflen) {
+			*buflen *= 2;
+			if ((newptr = realloc(*read_buf, *buflen + 1)) == NULL) {
+				printf("ERROR - realloc(%ld) failed, %d - %s\n", *buflen + 1, errno, strerror(errno));
+				exit(EXIT_FAILURE);
+			}
+			*read_buf = newptr;
+		}
+	}
+	close(fd);
 
-	for (int i=0; i<INO_HASH_SIZE; i++) {
-		hash_array[i] = NULL;
+	// Een laatste regel zonder '\n'.
+	if (have > 0 && !header) {
+		(*read_buf)[have] = '\0';
+		sock_ino_add_line(tab, pool_ino, *read_buf, family);
 	}
+	return 0;
+}
 
-	// Plaats het volledige bestand /proc/net/tcp in één grote buffer.
-	read_proc_file(net, read_buf, buflen);
+// Open een NETLINK_SOCK_DIAG socket en verstuur een dump-request.
+// Geeft de filedescriptor terug, of -1 wanneer sock_diag niet beschikbaar is.
+int sock_diag_request(void *req, size_t req_len) {
+	struct sockaddr_nl nladdr = { .nl_family = AF_NETLINK };
+	int fd;
 
-	// Lees de buffer en bouw daarmee de hash-table op.
-	char * line = strtok(*read_buf, "\n");
-	line  = strtok(NULL, "\n");       // Skip de eerste regel (=kopregel).
-	while(line) {
-		matchcnt = sscanf(line, " %*s %8x:%4x %8x:%4x %2x %*8x:%*8x %*2x:%*8x %*8x %u %*d %u ",
-			&addr_loc, (unsigned int *) &port_loc,
-			&addr_rem, (unsigned int *) &port_rem,
-			&state, &uid, &ino);
+	if ((fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG)) == -1)
+		return -1;
+	if (sendto(fd, req, req_len, 0, (struct sockaddr *) &nladdr, sizeof(nladdr)) == -1) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
 
-		// Sockets met inode number 0 zijn niet owned door een proces,
-		// dus die hoeven we niet op te nemen in de hash table.
-		if (ino) {
-			sock_ino_add(hash_array, pool_ino, ino, uid, addr_loc, port_loc, addr_rem, port_rem, state);
+// Lees de antwoorden op een dump-request en voeg de sockets toe aan de hash-table.
+// Geeft 0 terug bij succes, en -1 bij een fout.
+int sock_diag_receive(int fd, sock_ino_tab_t *tab, POOL *pool_ino, char *buf, long buflen,
+                      unsigned int family) {
+	struct nlmsghdr *h;
+	struct inet_diag_msg *m;
+	struct unix_diag_msg *u;
+	ssize_t len;
+
+	while (1) {
+		len = recv(fd, buf, buflen, 0);
+		if (len == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
 		}
+		for (h = (struct nlmsghdr *) buf; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+			if (h->nlmsg_type == NLMSG_DONE)
+				return 0;
+			if (h->nlmsg_type == NLMSG_ERROR)
+				return -1;
+
+			if (family == SOCK_FAM_UNIX) {
+				u = NLMSG_DATA(h);
+				if (u->udiag_ino) {
+					sock_ino_add(tab, pool_ino, u->udiag_ino, 0, 0, 0, 0, 0, u->udiag_state, family);
+				}
+				continue;
+			}
 
-		line  = strtok(NULL, "\n");
+			// Dezelfde waarden als in /proc/net/tcp: de adressen in network byte order
+			// zoals ze in het geheugen staan, de poortnummers in host byte order.
+			m = NLMSG_DATA(h);
+			if (m->idiag_inode) {
+				sock_ino_add(tab, pool_ino, m->idiag_inode, m->idiag_uid,
+				             m->idiag_family == AF_INET ? m->id.idiag_src[0] : 0, ntohs(m->id.idiag_sport),
+				             m->idiag_family == AF_INET ? m->id.idiag_dst[0] : 0, ntohs(m->id.idiag_dport),
+				             m->idiag_state, family);
+			}
+		}
 	}
 }
 
-void sock_ino_destroy_hash_table(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL *pool_ino) {
+// Bouw de hash-table op via NETLINK_SOCK_DIAG dumps (inet_diag en unix_diag).
+// De kernel levert binaire records.  Voor TCP filteren we in de kernel op de toestanden
+// die een owner kunnen hebben: TIME_WAIT en SYN_RECV (vaak het gros van de sockets op een
+// load balancer) hebben inode-nummer 0 en komen dus nooit in de telling terecht.
+// Geeft 0 terug bij succes, en -1 wanneer sock_diag niet beschikbaar is.
+int sock_ino_build_from_netlink(sock_ino_tab_t *tab, POOL *pool_ino, char **read_buf, long *buflen) {
+	static const struct {
+		unsigned char family;
+		unsigned char protocol;
+		unsigned int  sock_fam;
+	} dumps[] = {
+		{AF_INET,  IPPROTO_TCP, SOCK_FAM_TCP},
+		{AF_INET6, IPPROTO_TCP, SOCK_FAM_TCP6},
+		{AF_INET,  IPPROTO_UDP, SOCK_FAM_UDP},
+		{AF_INET6, IPPROTO_UDP, SOCK_FAM_UDP6},
+	};
+	struct {
+		struct nlmsghdr         nlh;
+		struct inet_diag_req_v2 r;
+	} req;
+	struct {
+		struct nlmsghdr         nlh;
+		struct unix_diag_req    r;
+	} ureq;
+	unsigned int tcp_states = SOCK_DIAG_ALL_STATES &
+	                          ~((1 << TCP_TIME_WAIT) | (1 << TCP_SYN_RECV) | (1 << SOCK_DIAG_NEW_SYN_RECV));
+	int fd, rc;
+
+	// De read-buffer van /proc/net/tcp wordt hergebruikt als ontvangstbuffer.
+	if (*read_buf == NULL) {
+		if ((*read_buf = malloc(*buflen + 1)) == NULL) {
+			printf("ERROR - malloc(%ld) failed, %d - %s\n", *buflen, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (int i=0; i<sizeof(dumps)/sizeof(dumps[0]); i++) {
+		memset(&req, 0, sizeof(req));
+		req.nlh.nlmsg_len      = sizeof(req);
+		req.nlh.nlmsg_type     = SOCK_DIAG_BY_FAMILY;
+		req.nlh.nlmsg_flags    = NLM_F_REQUEST | NLM_F_DUMP;
+		req.r.sdiag_family     = dumps[i].family;
+		req.r.sdiag_protocol   = dumps[i].protocol;
+		req.r.idiag_states     = dumps[i].protocol == IPPROTO_TCP ? tcp_states : SOCK_DIAG_ALL_STATES;
+
+		if ((fd = sock_diag_request(&req, sizeof(req))) == -1)
+			return -1;
+		rc = sock_diag_receive(fd, tab, pool_ino, *read_buf, *buflen, dumps[i].sock_fam);
+		close(fd);
+		// Zonder IPv6 (of zonder udp_diag) levert alleen die dump een fout op; die slaan we over.
+		// Zonder inet_diag voor IPv4 TCP heeft netlink geen zin en vallen we terug op /proc.
+		if (rc == -1 && dumps[i].sock_fam == SOCK_FAM_TCP)
+			return -1;
+	}
+
+	memset(&ureq, 0, sizeof(ureq));
+	ureq.nlh.nlmsg_len    = sizeof(ureq);
+	ureq.nlh.nlmsg_type   = SOCK_DIAG_BY_FAMILY;
+	ureq.nlh.nlmsg_flags  = NLM_F_REQUEST | NLM_F_DUMP;
+	ureq.r.sdiag_family   = AF_UNIX;
+	ureq.r.udiag_states   = SOCK_DIAG_ALL_STATES;
+	if ((fd = sock_diag_request(&ureq, sizeof(ureq))) != -1) {
+		sock_diag_receive(fd, tab, pool_ino, *read_buf, *buflen, SOCK_FAM_UNIX);
+		close(fd);
+	}
+	return 0;
+}
+
+void sock_ino_build_hash_table(sock_ino_tab_t *tab, POOL *pool_ino, char **read_buf, long *buflen) {
+	static int netlink_failed = 0;   // na een mislukte poging gebruiken we alleen nog /proc/net/*
+	static const struct {
+		const char   *env;
+		const char   *path;
+		unsigned int  family;
+	} files[] = {
+		{"PROC_TCP",  "/proc/net/tcp",  SOCK_FAM_TCP},
+		{"PROC_TCP6", "/proc/net/tcp6", SOCK_FAM_TCP6},
+		{"PROC_UDP",  "/proc/net/udp",  SOCK_FAM_UDP},
+		{"PROC_UDP6", "/proc/net/udp6", SOCK_FAM_UDP6},
+		{"PROC_UNIX", "/proc/net/unix", SOCK_FAM_UNIX},
+	};
+	unsigned long size = INO_TAB_MIN_SIZE;
+	char *net;
+
+	// Dimensioneer de tabel op het aantal sockets van het vorige interval (maximaal
+	// 50% bezetting), zodat er tijdens de opbouw normaal gesproken niet gerehasht hoeft
+	// te worden.  Krimp alleen wanneer de tabel ruim te groot geworden is.
+	while (size < tab->prev_used * 2)
+		size *= 2;
+	if (size > tab->size || size * 4 < tab->size)
+		sock_ino_tab_resize(tab, size);
+
+	// Wanneer PROC_TCP gezet is (bv. voor tests) lezen we altijd de bestanden.
+	if (!getenv("PROC_TCP") && !netlink_failed) {
+		if (sock_ino_build_from_netlink(tab, pool_ino, read_buf, buflen) == 0)
+			return;
+		// sock_diag is niet beschikbaar (bv. geen inet_diag module).  Gooi een eventueel
+		// half opgebouwde tabel weg en val terug op /proc/net/*.
+		netlink_failed = 1;
+		sock_ino_destroy_hash_table(tab, pool_ino);
+	}
+	for (int i=0; i<sizeof(files)/sizeof(files[0]); i++) {
+		net = getenv(files[i].env) ? : (char *) files[i].path;
+		// Zonder /proc/net/tcp heeft -s geen zin.  De andere bestanden zijn optioneel
+		// (bv. /proc/net/tcp6 op een systeem zonder IPv6).
+		if (sock_ino_build_from_proc(tab, pool_ino, read_buf, buflen, net, files[i].family) == -1 &&
+		    files[i].family == SOCK_FAM_TCP) {
+			printf("ERROR - open(%s) failed, %d - %s\n", net, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+void sock_ino_destroy_hash_table(sock_ino_tab_t *tab, POOL *pool_ino) {
 	pool_reset(pool_ino);
-	for (int i=0; i<INO_HASH_SIZE; i++) {
-		hash_array[i] = NULL;
+	// De slots-array blijft bestaan voor het volgende interval.
+	if (tab->slots)
+		memset(tab->slots, 0, tab->size * sizeof(sock_ino_slot_t));
+	tab->prev_used = tab->used;
+	tab->used = 0;
+}
+
+// Tel één socket van een proces mee in de aggregatie van een commando.
+static inline void sock_aggr_add(sock_aggr_t *sa, sock_ino_ent_t *p) {
+	sa->sock_total += 1;
+	if (!p)
+		return;
+	switch (p->family) {
+	case SOCK_FAM_TCP:  sa->family.tcp += 1;
+	                    break;
+	case SOCK_FAM_TCP6: sa->family.tcp6 += 1;
+	                    break;
+	case SOCK_FAM_UDP:  sa->family.udp += 1;
+	                    break;
+	case SOCK_FAM_UDP6: sa->family.udp6 += 1;
+	                    break;
+	case SOCK_FAM_UNIX: sa->family.unix_domain += 1;
+	                    break;
+	}
+	// De state-kolommen gaan alleen over TCP (IPv4 en IPv6).
+	if (p->family == SOCK_FAM_TCP || p->family == SOCK_FAM_TCP6) {
+		switch (p->state) {
+		case TCP_ESTABLISHED: sa->state.established += 1;
+		                      break;
+		case TCP_CLOSE_WAIT:  sa->state.close_wait += 1;
+		                      break;
+		case TCP_LISTEN:      sa->state.listener += 1;
+		                      break;
+		default:              ;  // no-op
+		}
 	}
 }
 
-sock_aggr_t * sock_ino_gather_cmd_stats(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL **pool_ino, char *cmd) {
-	const char *root = getenv("PROC_ROOT") ? : "/proc/";
-	struct dirent *d;
-	char name[INO_NAME_LEN_MAX];
-	int nameoff;
-	DIR *dir;
+// Parse een (positief) decimaal getal dat de hele string beslaat.
+// Geeft -1 terug wanneer de string iets anders bevat (bv. "self" of ".").
+static inline long ino_parse_num(const char *s) {
+	long val = 0;
+
+	if (!*s)
+		return -1;
+	for (; *s; s++) {
+		if ((unsigned) (*s - '0') >= 10)
+			return -1;
+		val = val * 10 + (*s - '0');
+	}
+	return val;
+}
+
+// Lees de directory-entries van <d->fd> in grote batches via getdents64.
+// Geeft de volgende entry terug, of NULL aan het einde van de directory (of bij een fout).
+static struct linux_dirent64 * ino_dents_next(ino_dents_t *d) {
+	struct linux_dirent64 *de;
+
+	if (d->pos >= d->len) {
+		d->len = syscall(SYS_getdents64, d->fd, d->buf, INO_DENTS_BUF_SIZE);
+		d->pos = 0;
+		if (d->len <= 0)
+			return NULL;
+	}
+	de = (struct linux_dirent64 *) (d->buf + d->pos);
+	d->pos += de->d_reclen;
+	return de;
+}
+
+// Lees de cmd-naam van een proces uit /proc/PID/comm (relatief aan de PID-directory).
+// Geeft 0 terug bij succes, en -1 wanneer het proces inmiddels verdwenen is.
+static int ino_read_comm(int pid_fd, char process[INO_PROCESS_LEN_MAX+1]) {
+	ssize_t len;
+	int fd;
+
+	if ((fd = openat(pid_fd, "comm", O_RDONLY | O_CLOEXEC)) == -1)
+		return -1;
+	len = read(fd, process, INO_PROCESS_LEN_MAX);
+	close(fd);
+	if (len <= 0)
+		return -1;
+	if (process[len-1] == '\n')
+		len--;
+	process[len] = '\0';
+	return 0;
+}
+
+// Doorloop /proc/PID/fd van één proces en tel de sockets mee bij de gematchte commando's.
+static void ino_scan_fds(sock_ino_tab_t *tab, int pid_fd, sock_aggr_t s[],
+                         const int *matched, int matched_cnt, sock_scan_stats_t *stats) {
+	static const char pattern[] = "socket:[";
+	char dents_buf[INO_DENTS_BUF_SIZE];
+	ino_dents_t d = { .buf = dents_buf, .len = 0, .pos = 0 };
+	struct linux_dirent64 *de;
 	sock_ino_ent_t *p;
-	static sock_aggr_t *s;
+	unsigned int ino;
+	char lnk[64];
+	ssize_t link_len;
 
-	s = pool_alloc(*pool_ino, (sizeof(sock_aggr_t)));
-	if (!s) {
-		if ((*pool_ino = pool_extend(*pool_ino)) == NULL) {
-			printf("ERROR - failed pool_extend() in sock_ino_gather_cmd_stats()\n");
-			exit(EXIT_FAILURE);
-		} else {
-			if ((s = pool_alloc(*pool_ino, sizeof(sock_aggr_t))) == NULL) {
-				printf("ERROR - failed pool_alloc sock_aggr_t (%ld bytes)\n", sizeof(sock_aggr_t));
-				exit(EXIT_FAILURE);
-			}
+	// In geval van een error gaan we gewoon door, want wanneer je niet als root
+	// draait heb je geen toegang tot de FD-directories van alle PID's.
+	if ((d.fd = openat(pid_fd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		stats->fd_dirs_failed++;
+		return;
+	}
+
+	while ((de = ino_dents_next(&d)) != NULL) {
+		// Vind alle entries in /proc/PID/fd/ waarvan de naam een getal is (=FD)
+		if (ino_parse_num(de->d_name) < 0)
+			continue;
+		stats->fds_scanned++;
+
+		// De FD is een link.  Vraag de naam van de bestemming van de link op.
+		// (aan die naam kun je zien of het een socket is, en hij bevat tevens het inode-nummer)
+		link_len = readlinkat(d.fd, de->d_name, lnk, sizeof(lnk)-1);
+		if (link_len <= (ssize_t) sizeof(pattern) - 1 || memcmp(lnk, pattern, sizeof(pattern) - 1))
+			continue;
+
+		// Het is een socket.  Vraag het inode-nummer op.
+		ino = 0;
+		for (char *c = lnk + sizeof(pattern) - 1; c < lnk + link_len && (unsigned) (*c - '0') < 10; c++)
+			ino = ino * 10 + (*c - '0');
+		stats->sockets_found++;
+
+		// We gaan nu de status van de socket bijzoeken in de hashtabel.
+		// Om diverse redenen zal niet elk socket ook voorkomen in de hashtabel.
+		// Daarom tellen we hier éérst alvast de socket, zodat er geen ontbreken in de totaaltelling.
+		// De hashtabel wordt per socket maar één keer geraadpleegd, ook als het proces
+		// bij meerdere commando's hoort.
+		p = sock_ino_find(tab, ino);
+		for (int i=0; i<matched_cnt; i++)
+			sock_aggr_add(&s[matched[i]], p);
+	}
+	close(d.fd);
+}
+
+// Tel de velden van aggregatie <src> op bij <dst>.
+static void sock_aggr_merge(sock_aggr_t *dst, sock_aggr_t *src) {
+	dst->sock_total         += src->sock_total;
+	dst->state.established  += src->state.established;
+	dst->state.close_wait   += src->state.close_wait;
+	dst->state.listener     += src->state.listener;
+	dst->family.tcp         += src->family.tcp;
+	dst->family.tcp6        += src->family.tcp6;
+	dst->family.udp         += src->family.udp;
+	dst->family.udp6        += src->family.udp6;
+	dst->family.unix_domain += src->family.unix_domain;
+}
+
+// Multithreaded scan (optie -j).
+//
+// De main thread doorloopt /proc/ zoals in de single-threaded versie, maar leest van elk
+// gematcht proces alleen de namen in /proc/PID/fd.  Alle fd's van alle processen komen in
+// één platte lijst.  De workers pakken daar om beurten een blok van INO_PAR_CHUNK fd's uit
+// (een gedeelde atomaire teller) en doen de readlinkat() en de lookup in de hash-table.
+// Een proces met 100k fd's wordt zo over alle workers verdeeld, in plaats van één worker
+// bezig te houden terwijl de rest klaar is.  De hash-table wordt alleen gelezen.
+// Elke worker telt in zijn eigen sock_aggr_t per commando; die worden na afloop opgeteld.
+//
+// Per proces blijft er niets open: de directory /proc/PID/fd wordt na het lezen van de namen
+// meteen gesloten, en de workers lezen de links via "<pid>/fd/<fd>" relatief aan /proc/.
+// Met duizenden gematchte processen loopt de scan zo niet tegen RLIMIT_NOFILE aan (de fd's
+// van -D/-e staan al open).  Wordt het PID-nummer in de tussentijd hergebruikt, dan telt één
+// fd van het nieuwe proces mee; dat is dezelfde onnauwkeurigheid als bij elke /proc-scan.
+// De workers blijven van interval tot interval bestaan (sock_ino_par_start()).
+static ino_par_t ino_par;
+
+static void * ino_par_grow(void *ptr, size_t *cap, size_t need, size_t elem_size) {
+	size_t new_cap = *cap ? *cap : INO_PAR_INITIAL_CAP;
+
+	if (need <= *cap)
+		return ptr;
+	while (new_cap < need)
+		new_cap *= 2;
+	if ((ptr = realloc(ptr, new_cap * elem_size)) == NULL) {
+		printf("ERROR - realloc(%ld) failed, %d - %s\n", new_cap * elem_size, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	*cap = new_cap;
+	return ptr;
+}
+
+// Registreer een gematcht proces en zet zijn fd's in de lijst.
+static void ino_par_add_job(ino_par_t *par, int pid_fd, int pid, const int *matched, int matched_cnt, sock_scan_stats_t *stats) {
+	char dents_buf[INO_DENTS_BUF_SIZE];
+	ino_dents_t d = { .buf = dents_buf, .len = 0, .pos = 0 };
+	struct linux_dirent64 *de;
+	ino_par_job_t *job;
+	long fd;
+
+	if ((d.fd = openat(pid_fd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		stats->fd_dirs_failed++;
+		return;
+	}
+
+	par->jobs  = ino_par_grow(par->jobs,  &par->job_cap,   par->job_cnt + 1, sizeof(ino_par_job_t));
+	par->match = ino_par_grow(par->match, &par->match_cap, par->match_cnt + matched_cnt, sizeof(int));
+	job = &par->jobs[par->job_cnt];
+	job->pid       = pid;
+	job->match_off = par->match_cnt;
+	job->match_cnt = matched_cnt;
+	memcpy(&par->match[par->match_cnt], matched, matched_cnt * sizeof(int));
+	par->match_cnt += matched_cnt;
+
+	while ((de = ino_dents_next(&d)) != NULL) {
+		if ((fd = ino_parse_num(de->d_name)) < 0)
+			continue;
+		stats->fds_scanned++;
+		par->items = ino_par_grow(par->items, &par->item_cap, par->item_cnt + 1, sizeof(ino_par_item_t));
+		par->items[par->item_cnt].job = par->job_cnt;
+		par->items[par->item_cnt].fd  = fd;
+		par->item_cnt++;
+	}
+	close(d.fd);
+	par->job_cnt++;
+}
+
+static void * ino_par_worker(void *arg) {
+	static const char pattern[] = "socket:[";
+	ino_par_worker_t *w = arg;
+	ino_par_t *par = w->par;
+	ino_par_item_t *item;
+	ino_par_job_t *job;
+	sock_ino_ent_t *p;
+	unsigned int ino;
+	char name[48], lnk[64];
+	ssize_t link_len;
+	size_t start, end;
+
+	while ((start = __atomic_fetch_add(&par->next, INO_PAR_CHUNK, __ATOMIC_RELAXED)) < par->item_cnt) {
+		end = start + INO_PAR_CHUNK < par->item_cnt ? start + INO_PAR_CHUNK : par->item_cnt;
+		for (size_t i=start; i<end; i++) {
+			item = &par->items[i];
+			job  = &par->jobs[item->job];
+			snprintf(name, sizeof(name), "%d/fd/%d", job->pid, item->fd);
+			link_len = readlinkat(par->proc_fd, name, lnk, sizeof(lnk)-1);
+			if (link_len <= (ssize_t) sizeof(pattern) - 1 || memcmp(lnk, pattern, sizeof(pattern) - 1))
+				continue;
+			ino = 0;
+			for (char *c = lnk + sizeof(pattern) - 1; c < lnk + link_len && (unsigned) (*c - '0') < 10; c++)
+				ino = ino * 10 + (*c - '0');
+			w->sockets_found++;
+
+			p = sock_ino_find(par->tab, ino);
+			for (int m=0; m<job->match_cnt; m++)
+				sock_aggr_add(&w->s[par->match[job->match_off + m]], p);
 		}
 	}
-	memset(s, 0, sizeof(sock_aggr_t));
+	return NULL;
+}
+
+// Een worker van de pool: wacht op een nieuwe generatie, doe de scan, en meld dat hij klaar is.
+static void * ino_par_thread(void *arg) {
+	ino_par_worker_t *w = arg;
+	ino_par_t *par = w->par;
+	unsigned long gen = 0;
+
+	pthread_mutex_lock(&par->lock);
+	for (;;) {
+		while (par->gen == gen && !par->stop)
+			pthread_cond_wait(&par->start, &par->lock);
+		if (par->stop)
+			break;
+		gen = par->gen;
+		pthread_mutex_unlock(&par->lock);
+		ino_par_worker(w);
+		pthread_mutex_lock(&par->lock);
+		if (--par->busy == 0)
+			pthread_cond_signal(&par->done);
+	}
+	pthread_mutex_unlock(&par->lock);
+	return NULL;
+}
+
+// Start <threads> - 1 workers voor de optie -j (de aanroepende thread doet zelf ook mee).
+// Lukt het starten van een worker niet, dan doen de overige het werk.  Moet na
+// tick_loop_create() aangeroepen worden, zodat de workers de geblokkeerde signals erven.
+void sock_ino_par_start(int threads) {
+	ino_par_t *par = &ino_par;
+
+	if (par->w || threads < 2)
+		return;
+	if ((par->w = calloc(threads, sizeof(ino_par_worker_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", threads * sizeof(ino_par_worker_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	pthread_mutex_init(&par->lock, NULL);
+	pthread_cond_init(&par->start, NULL);
+	pthread_cond_init(&par->done, NULL);
+	par->w[0].par = par;
+	for (par->threads=1; par->threads<threads; par->threads++) {
+		par->w[par->threads].par = par;
+		if (pthread_create(&par->w[par->threads].tid, NULL, ino_par_thread, &par->w[par->threads]) != 0)
+			break;
+	}
+}
+
+void sock_ino_par_stop(void) {
+	ino_par_t *par = &ino_par;
 
-	strcpy(name, root);
-	if (strnlen(name, INO_NAME_LEN_MAX) == 0 || name[strnlen(name, INO_NAME_LEN_MAX)-1] != '/')
-		strcat(name, "/");
+	if (!par->w)
+		return;
+	pthread_mutex_lock(&par->lock);
+	par->stop = 1;
+	pthread_cond_broadcast(&par->start);
+	pthread_mutex_unlock(&par->lock);
+	for (int t=1; t<par->threads; t++)
+		pthread_join(par->w[t].tid, NULL);
+	free(par->w);
+	free(par->aggr);
+	free(par->jobs);
+	free(par->match);
+	free(par->items);
+	memset(par, 0, sizeof(ino_par_t));
+}
 
-	nameoff = strnlen(name, INO_NAME_LEN_MAX);
+// Verdeel de verzamelde fd's over de workers (inclusief de aanroepende thread)
+// en tel de resultaten op in <s>.
+static void ino_par_run(ino_par_t *par, int cmd_cnt, sock_aggr_t s[], sock_scan_stats_t *stats) {
+	size_t n = (size_t) par->threads * (cmd_cnt > 0 ? cmd_cnt : 1);
+
+	par->aggr = ino_par_grow(par->aggr, &par->aggr_cap, n, sizeof(sock_aggr_t));
+	memset(par->aggr, 0, n * sizeof(sock_aggr_t));
+	par->next = 0;
+	for (int t=0; t<par->threads; t++) {
+		par->w[t].s = &par->aggr[t * cmd_cnt];
+		par->w[t].sockets_found = 0;
+	}
+
+	pthread_mutex_lock(&par->lock);
+	par->busy = par->threads - 1;
+	par->gen++;
+	pthread_cond_broadcast(&par->start);
+	pthread_mutex_unlock(&par->lock);
+	ino_par_worker(&par->w[0]);
+	pthread_mutex_lock(&par->lock);
+	while (par->busy > 0)
+		pthread_cond_wait(&par->done, &par->lock);
+	pthread_mutex_unlock(&par->lock);
+
+	for (int t=0; t<par->threads; t++) {
+		for (int i=0; i<cmd_cnt; i++)
+			sock_aggr_merge(&s[i], &par->w[t].s[i]);
+		stats->sockets_found += par->w[t].sockets_found;
+	}
+	par->job_cnt = par->match_cnt = par->item_cnt = 0;
+}
+
+void sock_ino_gather_cmd_stats(sock_ino_tab_t *tab, cmd_matcher_t *matcher, int threads,
+                               sock_aggr_t s[], sock_scan_stats_t *stats) {
+	const char *root = getenv("PROC_ROOT") ? : "/proc/";
+	char dents_buf[INO_DENTS_BUF_SIZE];
+	ino_dents_t d = { .buf = dents_buf, .len = 0, .pos = 0 };
+	struct linux_dirent64 *de;
+	char process[INO_PROCESS_LEN_MAX+1];
+	int cmd_cnt = matcher->pattern_cnt;
+	const int *matched;                      // indexen van de commando's waar het huidige proces bij hoort
+	int matched_cnt;
+	int pid_fd;
+	struct timespec ts_start, ts_end;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	memset(stats, 0, sizeof(sock_scan_stats_t));
+	if (threads > 1)
+		sock_ino_par_start(threads);      // normaal al gestart bij de start van het programma
+	memset(s, 0, cmd_cnt * sizeof(sock_aggr_t));
 
 	// Open de directory /proc/
-//	printf("INFO - Opening directory %s\n", name);                                        // DEBUG
-	dir = opendir(name);
-	if (!dir) {
-		printf("ERROR - failed to open %s, %d - %s\n", name, errno, strerror(errno));
+	// Alle opgegeven commando's worden in één enkele doorloop van /proc/ afgehandeld,
+	// zodat de kosten niet meer evenredig zijn met het aantal commando's maal het aantal PID's.
+	// Alle bestanden worden geopend relatief aan directory-filedescriptors (openat/readlinkat),
+	// zodat de kernel geen volledige paden hoeft op te zoeken.
+	if ((d.fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		printf("ERROR - failed to open %s, %d - %s\n", root, errno, strerror(errno));
 		exit(EXIT_FAILURE);
 	}
 
-	while ((d = readdir(dir)) != NULL) {
-		struct dirent *d1;
-		char process[INO_PROCESS_LEN_MAX+1];
-		int pid, pos;
-		DIR *dir1;
-		char crap;
-		
+	while ((de = ino_dents_next(&d)) != NULL) {
 		// Vind alle directories onder /proc/ waarvan de naam een getal is (=PID)
-//		printf("INFO - Scanning d_name %s\n", d->d_name);     // DEBUG
-		if (sscanf(d->d_name, "%d%c", &pid, &crap) != 1)
+		if (ino_parse_num(de->d_name) < 0)
 			continue;
-//		printf("INFO - Found PID %d\n", pid);                 // DEBUG
+		stats->pids_scanned++;
 
 		// Vraag de cmd-naam op.
 		// In geval van een error gaan we gewoon door, want het is altijd mogelijk
 		// dat een PID nèt verdwijnt tussen het moment dat we de directory lezen
 		// en het moment dat we de file openen om de cmd-naam uit te lezen.
-		FILE *fp;
-		char tmp[1024];
-		snprintf(tmp, sizeof(tmp), "%s/%d/stat", root, pid);
-		if ((fp = fopen(tmp, "r")) != NULL) {
-			if (fscanf(fp, "%*d (%[^)])", process) == EOF) {
-//				fprintf(stderr, "DEBUG: getting the cmd-name of PID %d failed: %d (%s)\n", pid, errno, strerror(errno));
-			}
-			fclose(fp);
-		}
-
-		// Check of dit de gevraagde cmd-naam is, zoek anders verder
-		if (strncmp(cmd, process, strnlen(cmd, INO_PROCESS_LEN_MAX))) {
-//			printf("Compare: %s != %s\n", cmd, process);  // DEBUG
+		if ((pid_fd = openat(d.fd, de->d_name, O_PATH | O_DIRECTORY | O_CLOEXEC)) == -1)
 			continue;
-//		} else {                                              // DEBUG
-//			printf("Scanning %s, PID %d\n", cmd, pid);    // DEBUG
-		}
-
-		// Open de  de filedescriptor-directory onder de gevonden PID-directory.
-		// In geval van een error gaan we gewoon door, want wanneer wanneer je niet
-		// als root draait heb je geen toegang tot de FD-directories van alle PID's.
-		sprintf(name + nameoff, "%d/fd/", pid);
-		pos = strnlen(name, INO_NAME_LEN_MAX);
-		if ((dir1 = opendir(name)) == NULL)
+		if (ino_read_comm(pid_fd, process) == -1) {
+			close(pid_fd);
 			continue;
+		}
 
-		process[0] = '\0';
-
-		while ((d1 = readdir(dir1)) != NULL) {
-			const char *pattern = "socket:[";
-			unsigned int ino;
-			char lnk[64];
-			int fd;
-			ssize_t link_len;
-
-			// Vind alle directories in /proc/PID/fd/ waarvan de naam een getal is (=FD)
-			if (sscanf(d1->d_name, "%d%c", &fd, &crap) != 1)
-				continue;
+		// Check welke van de gevraagde cmd-namen bij dit proces horen, zoek anders verder.
+		// Eén proces kan bij meerdere commando's horen (bv. -c nginx -c ngi).
+		matched_cnt = cmd_matcher_find(matcher, process, &matched);
+		if (matched_cnt > 0) {
+			stats->pids_matched++;
+			if (threads > 1)
+				ino_par_add_job(&ino_par, pid_fd, ino_parse_num(de->d_name), matched, matched_cnt, stats);
+			else
+				ino_scan_fds(tab, pid_fd, s, matched, matched_cnt, stats);
+		}
+		close(pid_fd);
+	}
 
-			sprintf(name+pos, "%d", fd);
+	if (threads > 1) {
+		ino_par.tab     = tab;
+		ino_par.proc_fd = d.fd;
+		ino_par_run(&ino_par, cmd_cnt, s, stats);
+	}
+	close(d.fd);
 
-			// De FD is een link.  Vraag de naam van de bestemming van de link op.
-			// (aan die naam kun je zien of het een socket is, en hij bevat tevens het inode-nummer)
-			link_len = readlink(name, lnk, sizeof(lnk)-1);
-			if (link_len == -1)
-				continue;
-			lnk[link_len] = '\0';
+	for (int i=0; i<cmd_cnt; i++) {
+		s[i].state.rest = s[i].sock_total - (s[i].state.established + s[i].state.close_wait + s[i].state.listener);
+	}
 
-			// Ga na of dit een link naar een socket is.
-			if (strncmp(lnk, pattern, strlen(pattern)))
-				continue;
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	stats->elapsed_us = (ts_end.tv_sec - ts_start.tv_sec) * 1000000LL +
+	                    (ts_end.tv_nsec - ts_start.tv_nsec) / 1000;
+}
 
-			// Het is een socket.  Vraag het inode-nummer op.
-			sscanf(lnk, "socket:[%u]", &ino);
-
-			// We gaan nu de status van de socket bijzoeken in de hashtabel.
-			// Om diverse redenen zal niet elk socket ook voorkomen in de hashtabel.
-			// Daarom tellen we hier éérst alvast de socket, zodat er geen ontbreken in de totaaltelling.
-			s->sock_total += 1;
-			p = sock_ino_find(hash_array, ino);
-			if (p) {
-				switch (p->state) {
-				case TCP_ESTABLISHED: s->state.established += 1;
-				                      break;
-				case TCP_CLOSE_WAIT:  s->state.close_wait += 1;
-				                      break;
-				case TCP_LISTEN:      s->state.listener += 1;
-				                      break;
-				default:              ;  // no-op
-				}
-//				sock_ino_print(p, pid);                     // DEBUG
-//				sock_aggr_print(s);                         // DEBUG
-			}
-		}
-		closedir(dir1);
-		s->state.rest = s->sock_total - (s->state.established + s->state.close_wait + s->state.listener);
-	}
-	closedir(dir);
-	return s;
+void sock_scan_stats_print(FILE *fp, sock_scan_stats_t *stats) {
+	fprintf(fp, "sock-scan: %lld us, pids: %lu, matched: %lu, fds: %lu, sockets: %lu, fd-dirs failed: %lu\n",
+	        stats->elapsed_us, stats->pids_scanned, stats->pids_matched,
+	        stats->fds_scanned, stats->sockets_found, stats->fd_dirs_failed);
 }
 
 #ifdef MODULE_TEST
 int main(int argc, char **argv) {
-	sock_ino_ent_t *sock_ino_ent_hash[INO_HASH_SIZE];
-	sock_aggr_t *s = NULL;
-
-	sock_ino_build_hash_table(sock_ino_ent_hash);
-	s = sock_ino_gather_cmd_stats(sock_ino_ent_hash, argv[1]);
-	sock_aggr_print(s);
-	sock_ino_destroy_hash_table(sock_ino_ent_hash);
-
-	sock_ino_build_hash_table(sock_ino_ent_hash);
-	s = sock_ino_gather_cmd_stats(sock_ino_ent_hash, argv[2]);
-	sock_aggr_print(s);
-	sock_ino_destroy_hash_table(sock_ino_ent_hash);
+	sock_ino_tab_t *tab = sock_ino_tab_create();
+	int cmd_cnt = argc - 1;
+	sock_aggr_t s[cmd_cnt > 0 ? cmd_cnt : 1];
+	cmd_matcher_t *matcher = cmd_matcher_create();
+	sock_scan_stats_t stats;
+	POOL *pool_ino = pool_create(1024*1024);
+	char *read_buf = NULL;
+	long buflen = INITIAL_READBUF_SIZE;
+
+	sock_ino_build_hash_table(tab, pool_ino, &read_buf, &buflen);
+	for (int i=0; i<cmd_cnt; i++)
+		cmd_matcher_add_cmd(matcher, argv[i+1]);
+	sock_ino_gather_cmd_stats(tab, matcher, getenv("INO_THREADS") ? atoi(getenv("INO_THREADS")) : 1, s, &stats);
+	for (int i=0; i<cmd_cnt; i++) {
+		printf("%-16s ", argv[i+1]);
+		sock_aggr_print(&s[i]);
+	}
+	sock_scan_stats_print(stdout, &stats);
+	sock_ino_destroy_hash_table(tab, pool_ino);
+	sock_ino_tab_destroy(tab);
+	pool_destroy(pool_ino);
+	cmd_matcher_destroy(matcher);
 }
 #endif  // MODULE_TEST
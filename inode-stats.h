@@ -25,9 +25,8 @@
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-// Struct voor de socket-nodes in de hash-table
+// Struct voor de socket-gegevens (opgeslagen in de memory-pool)
 struct sock_ino_ent {
-        struct sock_ino_ent *next;
         unsigned int    ino;
         unsigned int    uid;
         unsigned int    addr_loc;
@@ -35,6 +34,7 @@ struct sock_ino_ent {
         unsigned int    addr_rem;
         unsigned int    port_rem;
         unsigned int    state;
+        unsigned int    family;   // SOCK_FAM_TCP, SOCK_FAM_TCP6, SOCK_FAM_UDP, SOCK_FAM_UDP6 of SOCK_FAM_UNIX
 };
 
 struct sock_aggr {
@@ -46,18 +46,76 @@ struct sock_aggr {
 //      	unsigned long time_wait;  // TIME_WAIT heeft geen zin, want zulke sockets hebben geen owner/process
         	unsigned long rest;
 	} state;
+        struct family {           // aantallen per protocol-familie (sockets die niet in de hash-table staan tellen niet mee)
+	        unsigned long tcp;
+	        unsigned long tcp6;
+	        unsigned long udp;
+	        unsigned long udp6;
+	        unsigned long unix_domain;
+	} family;
 };
 
-typedef struct sock_ino_ent sock_ino_ent_t;
-typedef struct sock_aggr    sock_aggr_t;
+// Slot in de open-addressing hash-table.  Het inode-nummer staat in het slot zelf,
+// zodat het zoeken (linear probing) binnen de slots-array blijft en alleen bij een
+// treffer de node in de memory-pool geraadpleegd wordt.  ino == 0 betekent: leeg slot.
+struct sock_ino_slot {
+        unsigned int         ino;
+        struct sock_ino_ent *ent;
+};
+
+// De hash-table zelf.  De slots-array wordt hergebruikt van interval tot interval en
+// wordt bij de opbouw gedimensioneerd op het aantal sockets van het vorige interval.
+struct sock_ino_tab {
+        struct sock_ino_slot *slots;
+        unsigned long         size;       // aantal slots (macht van 2)
+        unsigned long         used;       // aantal gevulde slots
+        unsigned long         prev_used;  // aantal sockets bij de vorige opbouw
+};
+
+// Tellingen en doorlooptijd van één scan van /proc/ (zie de optie -T)
+struct sock_scan_stats {
+        long long     elapsed_us;
+        unsigned long pids_scanned;
+        unsigned long pids_matched;
+        unsigned long fds_scanned;
+        unsigned long sockets_found;
+        unsigned long fd_dirs_failed;     // /proc/PID/fd niet te openen (geen rechten, gestopt, EMFILE)
+};
+
+typedef struct sock_ino_ent   sock_ino_ent_t;
+typedef struct sock_ino_slot  sock_ino_slot_t;
+typedef struct sock_ino_tab   sock_ino_tab_t;
+typedef struct sock_aggr      sock_aggr_t;
+typedef struct sock_scan_stats sock_scan_stats_t;
+
+#define SOCK_FAM_TCP  0
+#define SOCK_FAM_TCP6 1
+#define SOCK_FAM_UDP  2
+#define SOCK_FAM_UDP6 3
+#define SOCK_FAM_UNIX 4
+#define SOCK_FAM_CNT  5
 
-#define INO_HASH_SIZE 256
+#define INO_TAB_MIN_SIZE 1024
 #define INITIAL_READBUF_SIZE (1024*1024)
 #define INO_PROCESS_LEN_MAX 16
-#define INO_NAME_LEN_MAX 1024
+#define INO_DENTS_BUF_SIZE 32768
 
-void sock_ino_build_hash_table(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL **pool_ino, char **read_buf, long *buflen);
-void sock_ino_destroy_hash_table(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL *pool_ino);
+sock_ino_tab_t * sock_ino_tab_create(void);
+void sock_ino_tab_destroy(sock_ino_tab_t *tab);
+void sock_ino_add(sock_ino_tab_t *tab, POOL *pool_ino,
+                  unsigned int ino, unsigned int uid,
+                  unsigned int addr_loc, unsigned int port_loc,
+                  unsigned int addr_rem, unsigned int port_rem,
+                  unsigned int state, unsigned int family);
+sock_ino_ent_t * sock_ino_find(sock_ino_tab_t *tab, unsigned int ino);
+int  sock_ino_build_from_proc(sock_ino_tab_t *tab, POOL *pool_ino, char **read_buf, long *buflen,
+                              const char *net, unsigned int family);
+void sock_ino_build_hash_table(sock_ino_tab_t *tab, POOL *pool_ino, char **read_buf, long *buflen);
+void sock_ino_destroy_hash_table(sock_ino_tab_t *tab, POOL *pool_ino);
 void sock_ino_print(sock_ino_ent_t *p, int pid);
 void sock_aggr_print(sock_aggr_t *s);
-sock_aggr_t * sock_ino_gather_cmd_stats(sock_ino_ent_t *hash_array[INO_HASH_SIZE], POOL **pool_ino, char *cmd);
+void sock_ino_gather_cmd_stats(sock_ino_tab_t *tab, cmd_matcher_t *matcher, int threads,
+                               sock_aggr_t s[], sock_scan_stats_t *stats);
+void sock_scan_stats_print(FILE *fp, sock_scan_stats_t *stats);
+void sock_ino_par_start(int threads);
+void sock_ino_par_stop(void);
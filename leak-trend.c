@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "leak-trend.h"
+
+void leak_est_init(leak_est_t *e, int win, double tau) {
+	memset(e, 0, sizeof(leak_est_t));
+	if (win < LEAK_WINDOW_MIN)
+		win = LEAK_WINDOW_MIN;
+	if (win > LEAK_WINDOW_MAX)
+		win = LEAK_WINDOW_MAX;
+	if ((e->ring = malloc(win * sizeof(e->ring[0]))) == NULL) {
+		printf("ERROR - malloc(%ld) failed, %d - %s\n", win * sizeof(e->ring[0]), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	e->win = win;
+	e->tau = tau;
+}
+
+void leak_est_free(leak_est_t *e) {
+	free(e->ring);
+	e->ring = NULL;
+}
+
+// Verschuif de oorsprong van de x-as d seconden naar rechts: x' = x - d.
+static inline void leak_sums_shift(struct leak_sums *s, double d) {
+	s->sxx -= 2 * d * s->sx - d * d * s->s0;
+	s->sx  -= d * s->s0;
+	s->sxy -= d * s->sy;
+}
+
+static inline void leak_sums_add(struct leak_sums *s, double x, double y, double w) {
+	s->s0  += w;
+	s->sww += w * w;
+	s->sx  += w * x;
+	s->sy  += w * y;
+	s->sxx += w * x * x;
+	s->sxy += w * x * y;
+	s->syy += w * y * y;
+}
+
+static inline void leak_sums_sub(struct leak_sums *s, double x, double y) {
+	s->s0  -= 1;
+	s->sww -= 1;
+	s->sx  -= x;
+	s->sy  -= y;
+	s->sxx -= x * x;
+	s->sxy -= x * y;
+	s->syy -= y * y;
+}
+
+// Gewogen kleinste-kwadraten helling en de t-waarde daarvan.
+static void leak_sums_fit(const struct leak_sums *s, double *slope, double *t) {
+	double n_eff, cxx, cxy, cyy, b, sse, se;
+
+	*slope = 0;
+	*t     = 0;
+	if (s->s0 <= 0 || s->sww <= 0)
+		return;
+	n_eff = s->s0 * s->s0 / s->sww;
+	cxx = s->sxx - s->sx * s->sx / s->s0;
+	if (n_eff < 3 || cxx <= 0)
+		return;
+	cxy = s->sxy - s->sx * s->sy / s->s0;
+	cyy = s->syy - s->sy * s->sy / s->s0;
+	b   = cxy / cxx;
+	sse = cyy - b * cxy;
+	se  = sse > 0 ? sqrt(sse / (n_eff - 2) / cxx) : 0;
+	*slope = b;
+	// Een perfect rechte lijn heeft geen standaardfout; geef dan een grote t-waarde.
+	*t = se > 0 ? b / se : (b > 0 ? 1e9 : (b < 0 ? -1e9 : 0));
+}
+
+// De waarde van de gewogen regressielijn op x (s, t.o.v. de laatste sample).
+static inline double leak_sums_predict(const struct leak_sums *s, double slope, double x) {
+	return s->s0 > 0 ? (s->sy - slope * s->sx) / s->s0 + slope * x : 0;
+}
+
+// Bereken de sommen van het venster opnieuw (tegen het oplopen van afrondingsfouten).
+static void leak_sw_recompute(leak_est_t *e) {
+	int i, k;
+
+	memset(&e->sw, 0, sizeof(e->sw));
+	for (i=0; i<e->cnt; i++) {
+		k = (e->head + i) % e->win;
+		leak_sums_add(&e->sw, e->ring[k][0] - e->t_last, e->ring[k][1], 1);
+	}
+}
+
+// Voeg de sample y (KiB) op tijdstip t (s) toe.  Geeft 1 terug als er vanaf nu een lek
+// vermoed wordt, -1 als het vermoeden vervalt, en anders 0.
+int leak_est_add(leak_est_t *e, double t, double y, long proc_cnt) {
+	double d, lambda, xo, yo;
+	int k, was = e->suspected;
+
+	if (e->n == 0) {
+		// De eerste sample is het nulpunt; dat houdt de sommen klein.
+		e->y_off  = -y;
+		e->t_last = t;
+	} else if (proc_cnt != e->proc_prev) {
+		// Laat de nieuwe sample aansluiten op de voorspelling van de ew-schatting.
+		e->y_off = leak_sums_predict(&e->ew, e->ew_slope, t - e->t_last) - y;
+	}
+	y += e->y_off;
+	d  = t - e->t_last;
+
+	// Exponentieel gewogen: verschuif, laat de oude gewichten vervallen, en tel de nieuwe sample op.
+	lambda = exp(-d / e->tau);
+	leak_sums_shift(&e->ew, d);
+	e->ew.s0  *= lambda;
+	e->ew.sww *= lambda * lambda;
+	e->ew.sx  *= lambda;
+	e->ew.sy  *= lambda;
+	e->ew.sxx *= lambda;
+	e->ew.sxy *= lambda;
+	e->ew.syy *= lambda;
+	leak_sums_add(&e->ew, 0, y, 1);
+
+	// Schuivend venster: de oudste sample valt eruit zodra het venster vol is.
+	leak_sums_shift(&e->sw, d);
+	if (e->cnt == e->win) {
+		xo = e->ring[e->head][0] - t;
+		yo = e->ring[e->head][1];
+		leak_sums_sub(&e->sw, xo, yo);
+		e->head = (e->head + 1) % e->win;
+		e->cnt--;
+	}
+	k = (e->head + e->cnt) % e->win;
+	e->ring[k][0] = t;
+	e->ring[k][1] = y;
+	e->cnt++;
+	e->t_last = t;
+	leak_sums_add(&e->sw, 0, y, 1);
+	if (++e->n % e->win == 0)
+		leak_sw_recompute(e);
+
+	e->y_prev    = y;
+	e->proc_prev = proc_cnt;
+	leak_sums_fit(&e->ew, &e->ew_slope, &e->ew_t);
+	leak_sums_fit(&e->sw, &e->sw_slope, &e->sw_t);
+
+	if (!e->suspected) {
+		if (e->cnt == e->win &&
+		    e->ew_t >= LEAK_T_MIN && e->ew_slope * 3600 >= LEAK_MIN_KIB_H &&
+		    e->sw_t >= LEAK_T_MIN && e->sw_slope * 3600 >= LEAK_MIN_KIB_H)
+			e->persist++;
+		else
+			e->persist = 0;
+		if (e->persist >= e->win / 4)
+			e->suspected = 1;
+	} else {
+		if (e->ew_t < LEAK_T_MIN / 2 || e->ew_slope <= 0) {
+			e->suspected = 0;
+			e->persist   = 0;
+		}
+	}
+	return e->suspected - was;
+}
+
+#ifdef MODULE_TEST
+// Synthetische reeksen: vlak met ruis, een lek van 5 MiB/uur met ruis, een zaagtand
+// (groei en herstart, geen lek), en een sprong door een extra proces.
+static double noise(void) {
+	return (rand() / (double)RAND_MAX - 0.5) * 2048;        // +/- 1 MiB
+}
+
+static void run(const char *name, int kind) {
+	leak_est_t e;
+	double t, y;
+	long procs;
+	int i, tr, first = -1, flips = 0;
+
+	srand(1);
+	leak_est_init(&e, 3600, 3600);                        // een uur bij een interval van 1 s
+	for (i=0; i<8*3600; i++) {
+		t = i;
+		procs = 4;
+		y = 400000 + noise();
+		switch (kind) {
+		case 1: y += 5 * 1024 * t / 3600;                  break;
+		case 2: y += 20 * 1024 * ((i % 600) / 600.0);      break;
+		case 3: if (i > 4*3600) { y += 100000; procs = 5; } break;
+		}
+		tr = leak_est_add(&e, t, y, procs);
+		if (tr > 0 && first < 0)
+			first = i;
+		flips += tr != 0;
+	}
+	printf("%-10s ew: %+8.2f MiB/h (t=%8.1f)  sw: %+8.2f MiB/h (t=%8.1f)  suspected: %d  first after: %d s, changes: %d\n", name,
+	       e.ew_slope * 3600 / 1024, e.ew_t, e.sw_slope * 3600 / 1024, e.sw_t, e.suspected, first, flips);
+	leak_est_free(&e);
+}
+
+int main(int argc, char **argv) {
+	run("flat", 0);
+	run("leak", 1);
+	run("sawtooth", 2);
+	run("step", 3);
+	exit(EXIT_SUCCESS);
+}
+#endif  // MODULE_TEST
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Online schatting van de RSS-trend per commando (optie -L), om een geheugenlek te
+// herkennen zonder weken aan logregels door te lezen.
+//
+// Per commando lopen twee kleinste-kwadraten schattingen van de helling (KiB/s) mee:
+//   - ew: exponentieel gewogen, tijdconstante tau.  Oude samples tellen steeds minder mee.
+//   - sw: een schuivend venster van de laatste win samples, alle samples even zwaar.
+// Beide worden per sample in O(1) bijgewerkt met lopende sommen.  De sommen staan ten
+// opzichte van het tijdstip van de laatste sample, zodat ze begrensd blijven hoe lang het
+// programma ook draait; de sommen van het venster worden elke win samples opnieuw uit het
+// venster berekend tegen het wegdrijven van afrondingsfouten.
+//
+// Als betrouwbaarheid wordt de t-waarde van de helling gebruikt (helling / standaardfout).
+// RSS-reeksen zijn sterk autogecorreleerd, dus de t-waarde is geen echte kans; een lek
+// wordt pas vermoed als beide schattingen een flinke t-waarde en helling hebben en het
+// venster vol is, en dat een kwart venster lang achter elkaar zo blijft.  Het vermoeden vervalt
+// pas weer bij de halve drempel, zodat het signaal niet klappert.
+//
+// Een verandering van het aantal processen geeft een sprong in de totale RSS die geen lek
+// is (een extra worker, een herstart).  Die sprong wordt weggecorrigeerd.
+
+#define LEAK_WINDOW_MIN      8             // minimum aantal samples in het venster
+#define LEAK_WINDOW_MAX      4096          // maximum, begrenst het geheugen per commando
+#define LEAK_T_MIN           5.0           // t-waarde vanaf waar een lek vermoed wordt
+#define LEAK_MIN_KIB_H       1024.0        // en de minimale groei (KiB/uur)
+
+struct leak_sums {
+	double s0;                         // som van de gewichten
+	double sww;                        // som van de kwadraten van de gewichten (effectief aantal samples)
+	double sx, sy, sxx, sxy, syy;      // x in seconden t.o.v. de laatste sample, y in KiB
+};
+
+struct leak_est {
+	double tau;                        // tijdconstante van ew (s)
+	int    win;                        // lengte van het venster (samples)
+	int    cnt;                        // aantal samples in het venster
+	int    head;                       // positie van de oudste sample in het venster
+	unsigned long n;                   // aantal samples sinds de start
+	double t_last;                     // tijdstip van de laatste sample (s)
+	double y_off;                      // correctie voor sprongen door een ander aantal processen
+	double y_prev;                     // gecorrigeerde waarde van de laatste sample
+	long   proc_prev;                  // aantal processen bij de laatste sample
+	double (*ring)[2];                 // het venster: tijdstip en gecorrigeerde waarde
+	struct leak_sums ew;
+	struct leak_sums sw;
+	double ew_slope, ew_t;             // resultaat, helling in KiB/s
+	double sw_slope, sw_t;
+	int    persist;                    // aantal samples op rij dat aan de drempels voldaan is
+	int    suspected;
+};
+
+typedef struct leak_est leak_est_t;
+
+void leak_est_init(leak_est_t *e, int win, double tau);
+void leak_est_free(leak_est_t *e);
+int  leak_est_add(leak_est_t *e, double t, double y, long proc_cnt);
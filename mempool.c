@@ -31,37 +31,75 @@
 #include <stdlib.h>
 #include "mempool.h"
 
-POOL * pool_create(size_t size) {
-	size_t remainder;
+// Alloceer een chunk van (minimaal) <size> bruikbare bytes.
+static POOL_CHUNK * pool_chunk_new(size_t size) {
+	POOL_CHUNK *c = (POOL_CHUNK *) malloc(sizeof(POOL_CHUNK) + size);
+	if (c) {
+		c->next = NULL;
+		c->size = size;
+		return c;
+	} else {
+		printf("ERROR - failed malloc(%ld) %d - %s\n", size + sizeof(POOL_CHUNK), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+// Maak chunk <c> de huidige chunk.
+static void pool_chunk_enter(POOL *p, POOL_CHUNK *c) {
+	p->curr = c;
+	p->next = (char *) &c[1];  // registreer de start van de chunk
+	p->end  = p->next + c->size;   // registreer het einde van de chunk
+}
 
-	POOL *p = (POOL *) malloc(size + sizeof(POOL));
+POOL * pool_create_aligned(size_t size, size_t align) {
+	POOL *p = (POOL *) malloc(sizeof(POOL));
 	if(p) {
-		p->size = size;
-		p->next = (char *) &p[1];  // registreer de start van de memory-pool
-		remainder = (size_t) ((unsigned long long) (p->next) % 4);
-		if (remainder == 0)
-			remainder = 4;
-		p->next = p->next + 4 - remainder;  // 32-bit aligned
-		p->end = p->next + size;   // registreer het einde van de memory-pool
+		if (align == 0 || (align & (align - 1))) {
+			printf("ERROR - pool alignment %ld is not a power of 2\n", align);
+			exit(EXIT_FAILURE);
+		}
+		p->size  = size;
+		p->align = align;
+		p->first = pool_chunk_new(size);
+		p->used = p->high_water = 0;
+		p->extend_cnt = 0;
+		pool_chunk_enter(p, p->first);
 		return p;
 	} else {
-		printf("ERROR - failed malloc(%ld) %d - %s\n", size + sizeof(POOL), errno, strerror(errno));
+		printf("ERROR - failed malloc(%ld) %d - %s\n", sizeof(POOL), errno, strerror(errno));
 		exit(EXIT_FAILURE);
 	}
 }
 
+POOL * pool_create(size_t size) {
+	return pool_create_aligned(size, POOL_ALIGN_DEFAULT);
+}
+
 void pool_destroy(POOL *p) {
+	POOL_CHUNK *c, *c_next;
+
+	for (c = p->first; c; c = c_next) {
+		c_next = c->next;
+		free(c);
+	}
 	free(p);
 }
 
 void pool_reset(POOL *p) {
-	size_t remainder;
+	POOL_CHUNK *c, *c_next;
 
-	p->next = (char *) &p[1];  // reset de pointer naar de start van de memory-pool
-	remainder = (size_t) ((unsigned long long) (p->next) % 4);
-	if (remainder == 0)
-		remainder = 4;
-	p->next = p->next + 4 - remainder;  // 32-bit aligned
+	// Zijn er in de vorige ronde chunks bijgekomen, vervang ze dan door één chunk ter
+	// grootte van de totale capaciteit.  De volgende ronde past er dan in één keer in
+	// (het high-water mark wordt hergebruikt) en ligt het geheugen weer aaneengesloten.
+	if (p->first->next) {
+		for (c = p->first; c; c = c_next) {
+			c_next = c->next;
+			free(c);
+		}
+		p->first = pool_chunk_new(p->size);
+	}
+	p->used = 0;
+	pool_chunk_enter(p, p->first);  // reset de pointer naar de start van de memory-pool
 }
 
 size_t pool_size(POOL *p) {
@@ -69,84 +107,94 @@ size_t pool_size(POOL *p) {
 }
 
 size_t pool_available(POOL *p) {
-	return (p->end) - (p->next);
+	size_t avail = (p->end) - (p->next);
+	POOL_CHUNK *c;
+
+	for (c = p->curr->next; c; c = c->next)
+		avail += c->size;
+	return avail;
 }
 
-void * pool_alloc(POOL *p, size_t size) {
-	size_t remainder;
+size_t pool_high_water(POOL *p) {
+	return p->high_water;
+}
 
-//	printf("pool_alloc(%p, %lld), available: %d", p, size, pool_available(p));
-	if (pool_available(p) < size) {
-//		printf(" - NO SPACE LEFT IN POOL!!!\n");
-		return NULL;
-	} else {
-		void *mem = (void *) p->next;
-//		printf(", returned address %p\n", mem);
-//		printf("Adres POOL-start before alignment:  %p\n", p->next + size);  // DEBUG
-		remainder = (size_t) ((unsigned long long) (p->next + size) % 4);
-//		printf("Remainder: %d\n", remainder);                                // DEBUG
-		if (remainder == 0)
-			remainder = 4;
-		p->next += size + 4 - remainder;  // 32-bit aligned
-//		printf("Adres POOL-start after  alignment:  %p\n", p->next);         // DEBUG
-		return mem;
-	}
+unsigned long pool_extend_count(POOL *p) {
+	return p->extend_cnt;
 }
 
-POOL * pool_extend(POOL *p) {
-	POOL *p_new;
-	size_t remainder;
-
-//	printf("pool_extend() REALLOC REQUESTED!!!\n");
-//	printf("pool_extend() Size of POOL struct: %d\n", sizeof(POOL));
-//	printf("pool_extend() available: %d, pool size: %lld\n", pool_available(p), pool_size(p));
-	char *old_p    = (char *) p;
-	char *old_next = (char *) (p->next);
-	size_t old_size = p->size;
-	size_t new_size = (p->size)*2;
-//	printf("pool_extend() old_p    before realloc to %d bytes: %p\n", new_size, old_p);
-//	printf("pool_extend() old_next before realloc to %d bytes: %p\n", new_size, old_next);
-//	printf("pool_extend() pool pointer p before realloc to %d bytes: %p\n", new_size, p);
-//	printf("pool_extend() calling realloc(%p, %lld\n", p, new_size + sizeof(POOL));
-	p_new = realloc(p, new_size + sizeof(POOL));
-//	printf("pool_extend() pool pointer p after  realloc to %d bytes: %p\n", new_size, p_new);
-	if (p_new) {
-		// Pool-size extension geslaagd!  Pas de metadata aan.
-		p_new->size = new_size;
-		char *new_p    = (char *) p_new;
-		char *new_next = new_p + (old_next - old_p);
-		p_new->next = (char *) new_next;
-		p_new->end  = (char *) p_new + new_size + sizeof(POOL);
-//		printf("pool_extend() new p: %p, p->next: %p, p->end: %p, p->size: %p\n", p_new, p_new->next, p_new->end, p_new->size);
-//		printf("pool_extend() available: %d, pool size: %d\n", pool_available(p_new), pool_size(p_new));
+void * pool_alloc_aligned(POOL *p, size_t size, size_t align) {
+	char *mem;
+
+	while (1) {
+		mem = (char *) (((unsigned long) p->next + align - 1) & ~(unsigned long) (align - 1));
+		if (mem + size <= p->end)
+			break;
+		// Geen ruimte meer in de huidige chunk.  Ga door in de volgende chunk,
+		// of hang een nieuwe chunk achter de keten.
+		if (p->curr->next)
+			pool_chunk_enter(p, p->curr->next);
+		else
+			pool_extend(p, size + align);
 	}
-	return p_new;
+	p->used += (mem + size) - p->next;
+	if (p->used > p->high_water)
+		p->high_water = p->used;
+	p->next = mem + size;
+	return (void *) mem;
+}
+
+void * pool_alloc(POOL *p, size_t size) {
+	return pool_alloc_aligned(p, size, p->align);
+}
+
+// Voeg een chunk toe aan het einde van de keten, minimaal <min_size> bytes groot en
+// minimaal zo groot als de totale capaciteit tot nu toe (de capaciteit verdubbelt dus).
+// In tegenstelling tot de oude realloc()-implementatie verplaatst er niets: de POOL
+// pointer en alle eerder gealloceerde blokken blijven geldig.
+POOL * pool_extend(POOL *p, size_t min_size) {
+	POOL_CHUNK *c;
+	size_t new_size = p->size > min_size ? p->size : min_size;
+
+	// pool_extend() wordt alleen vanaf de laatste chunk aangeroepen
+	while (p->curr->next)
+		p->curr = p->curr->next;
+	c = pool_chunk_new(new_size);
+	p->curr->next = c;
+	p->size += new_size;
+	p->extend_cnt++;
+	pool_chunk_enter(p, c);
+	return p;
 }
 
 #ifdef MODULE_TEST
 int main(int argc, char **argv) {
 	POOL *p;
 
-	p = pool_create(1024*1024);
-	printf("Mem avail: %d\n", pool_available(p));
+	p = pool_create(64);
+	printf("Mem avail: %ld\n", pool_available(p));
 	char *bla  = (char *) pool_alloc(p, 10*sizeof(char));
 	char *bla2 = (char *) pool_alloc(p, 12*sizeof(char));
-	char *bla3 = (char *) pool_alloc(p, 13*sizeof(char));
+	char *bla3 = (char *) pool_alloc_aligned(p, 13*sizeof(char), 64);
 	strcpy(bla,  "Testje");
 	strcpy(bla2, "Testje2");
 	strcpy(bla3, "Testje3");
 	printf("De variable bla  bevat de tekst \"%s\"\n", bla);
 	printf("De variable bla2 bevat de tekst \"%s\"\n", bla2);
 	printf("De variable bla3 bevat de tekst \"%s\"\n", bla3);
-	printf("Size  POOL-struct: 0x%x\n", sizeof(POOL));
-	printf("Adres POOL-start:  %p\n", p);
-	printf("Adres POOL-end:    %p\n", p->end);
+	printf("Size  POOL-struct: 0x%lx\n", sizeof(POOL));
 	printf("Adres bla:         %p\n", bla);
 	printf("Adres bla2:        %p\n", bla2);
-	printf("Adres bla3:        %p\n", bla3);
-	printf("Pool size: %d\n", pool_size(p));
-	printf("Pool free: %d\n", pool_available(p));
-	printf("Pool used: %d\n", pool_size(p) - pool_available(p));
+	printf("Adres bla3:        %p (64-byte aligned: %s)\n", bla3, ((unsigned long) bla3 % 64) ? "no" : "yes");
+	for (int i=0; i<100; i++)
+		pool_alloc(p, 24);
+	printf("bla na 100 extra allocaties: \"%s\" (niet verplaatst)\n", bla);
+	printf("Pool size: %ld, extends: %lu, high-water: %ld\n", pool_size(p), pool_extend_count(p), pool_high_water(p));
+	pool_reset(p);
+	for (int i=0; i<100; i++)
+		pool_alloc(p, 24);
+	printf("Na reset:  %ld, extends: %lu, high-water: %ld, chunks: %s\n", pool_size(p), pool_extend_count(p),
+	       pool_high_water(p), p->first->next ? "meerdere" : "één");
 	pool_destroy(p);
 }
 #endif  // MODULE_TEST
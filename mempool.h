@@ -25,16 +25,36 @@
  * OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-typedef struct pool {
+// Een memory-pool bestaat uit een keten van chunks.  Wanneer de huidige chunk vol is
+// wordt er een nieuwe chunk achter gehangen; bestaande chunks worden nooit verplaatst,
+// zodat pointers naar eerder gealloceerd geheugen geldig blijven tot pool_reset().
+typedef struct pool_chunk {
+	struct pool_chunk *next;
 	size_t size;
-	char *next;
-	char *end;
+} POOL_CHUNK;
+
+typedef struct pool {
+	size_t size;          // totale capaciteit van alle chunks
+	size_t align;         // alignment van pool_alloc() (macht van 2)
+	char *next;           // eerste vrije byte in de huidige chunk
+	char *end;            // einde van de huidige chunk
+	POOL_CHUNK *first;
+	POOL_CHUNK *curr;
+	size_t used;          // gealloceerde bytes sinds de laatste pool_reset()
+	size_t high_water;    // hoogste waarde van used
+	unsigned long extend_cnt;  // aantal keren dat er een chunk is bijgekomen
 } POOL;
 
+#define POOL_ALIGN_DEFAULT 8
+
 POOL * pool_create(size_t size);
-POOL * pool_extend(POOL *p);
+POOL * pool_create_aligned(size_t size, size_t align);
+POOL * pool_extend(POOL *p, size_t min_size);
 void   pool_destroy(POOL *p);
 void   pool_reset(POOL *p);
 size_t pool_size(POOL *p);
 size_t pool_available(POOL *p);
+size_t pool_high_water(POOL *p);
+unsigned long pool_extend_count(POOL *p);
 void * pool_alloc(POOL *p, size_t size);
+void * pool_alloc_aligned(POOL *p, size_t size, size_t align);
@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "out-fmt.h"
+
+#define OUT_NUM_LEN 48                 // ruim voldoende voor een long of een float met 2 decimalen
+
+out_t * out_create(out_fmt_t fmt) {
+	out_t *o;
+
+	if ((o = calloc(1, sizeof(out_t))) == NULL ||
+	    (o->buf = malloc(OUT_BUF_SIZE)) == NULL) {
+		printf("ERROR - malloc(%d) failed, %d - %s\n", OUT_BUF_SIZE, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	o->fmt = fmt;
+	o->fd  = -1;
+	o->cap = OUT_BUF_SIZE;
+	return o;
+}
+
+void out_destroy(out_t *o) {
+	out_flush(o);
+	free(o->buf);
+	free(o);
+}
+
+int out_parse_fmt(const char *s, out_fmt_t *fmt) {
+	if (strcmp(s, "table") == 0)
+		*fmt = OUT_FMT_TABLE;
+	else if (strcmp(s, "csv") == 0)
+		*fmt = OUT_FMT_CSV;
+	else if (strcmp(s, "json") == 0)
+		*fmt = OUT_FMT_JSON;
+	else
+		return -1;
+	return 0;
+}
+
+void out_flush(out_t *o) {
+	int fd = o->fd != -1 ? o->fd : fileno(stdout);
+	size_t off = 0;
+	ssize_t n;
+
+	// Eventuele output die nog via stdio loopt moet er eerst uit, anders raakt de volgorde zoek.
+	if (o->fd == -1)
+		fflush(stdout);
+	while (off < o->len) {
+		if ((n = write(fd, o->buf + off, o->len - off)) == -1) {
+			if (errno == EINTR)
+				continue;
+			// Net als stdio: de output gaat verloren, het meten gaat door.
+			break;
+		}
+		off += n;
+	}
+	o->len = 0;
+}
+
+// Zorg dat er ruimte is voor nog n bytes.  Meestal is dat een flush; alleen een veld dat groter
+// is dan de hele buffer laat de buffer groeien.
+static inline void out_reserve(out_t *o, size_t n) {
+	char *p;
+
+	if (o->len + n <= o->cap)
+		return;
+	out_flush(o);
+	if (n > o->cap) {
+		if ((p = realloc(o->buf, n)) == NULL) {
+			printf("ERROR - realloc(%ld) failed, %d - %s\n", n, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		o->buf = p;
+		o->cap = n;
+	}
+}
+
+void out_printf(out_t *o, const char *fmt, ...) {
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(o->buf + o->len, o->cap - o->len, fmt, ap);
+	va_end(ap);
+	if (n < 0)
+		return;
+	if ((size_t)n >= o->cap - o->len) {
+		out_reserve(o, n + 1);
+		va_start(ap, fmt);
+		n = vsnprintf(o->buf + o->len, o->cap - o->len, fmt, ap);
+		va_end(ap);
+	}
+	o->len += n;
+}
+
+// Schrijf een getal van rechts naar links in de buffer die eindigt bij end.  Geeft het begin terug.
+static inline char * fmt_ulong(char *end, unsigned long v) {
+	do {
+		*--end = '0' + v % 10;
+		v /= 10;
+	} while (v);
+	return end;
+}
+
+static inline char * fmt_long(char *end, long v) {
+	char *p;
+
+	if (v >= 0)
+		return fmt_ulong(end, v);
+	p = fmt_ulong(end, -(unsigned long)v);
+	*--p = '-';
+	return p;
+}
+
+// Formatteer f als printf("%.2f", f).  De float wordt exact ontleed (f = m * 2^e) en
+// de afronding op 2 decimalen gebeurt met gehele getallen, round-half-even zoals glibc.
+// Het resultaat is daardoor byte-identiek aan de oude uitvoer, ook waar (float)ticks/tps
+// een afrondingsfout heeft.  Voor getallen die niet in 64 bits passen (en inf/nan) wordt
+// alsnog snprintf() gebruikt.
+static char * fmt_fixed2(char *end, float f) {
+	union { float f; uint32_t u; } bits = { .f = f };
+	int exp = (bits.u >> 23) & 0xff;
+	uint64_t m = bits.u & 0x7fffff;
+	uint64_t q, r, half;
+	int e, k, len;
+	char *p;
+
+	if (exp == 0xff || exp > 150 + 32) {
+		char tmp[OUT_NUM_LEN];
+
+		len = snprintf(tmp, sizeof(tmp), "%.2f", f);
+		if (len >= OUT_NUM_LEN)
+			len = OUT_NUM_LEN - 1;
+		p = end - len;
+		memcpy(p, tmp, len);
+		return p;
+	}
+	if (exp == 0) {
+		e = -149;
+	} else {
+		m |= 0x800000;
+		e = exp - 150;
+	}
+
+	if (e >= 0) {
+		q = (m << e) * 100;
+	} else {
+		k = -e;
+		if (k >= 40) {
+			q = 0;                       // m*100 < 2^31, dus kleiner dan 0.005
+		} else {
+			q = (m * 100) >> k;
+			r = (m * 100) & ((1ULL << k) - 1);
+			half = 1ULL << (k - 1);
+			if (r > half || (r == half && (q & 1)))
+				q++;
+		}
+	}
+	*--end = '0' + q % 10;
+	*--end = '0' + q / 10 % 10;
+	*--end = '.';
+	p = fmt_ulong(end, q / 100);
+	if (bits.u >> 31)
+		*--p = '-';
+	return p;
+}
+
+// Begin een veld: reserveer ruimte en schrijf het scheidingsteken of de JSON-sleutel.
+// Geeft 0 terug als het veld niets hoeft op te leveren.
+static inline int out_field_begin(out_t *o, const char *sep, const char *name, size_t need) {
+	size_t n;
+
+	if (o->header && o->fmt != OUT_FMT_CSV)
+		return 0;
+	out_reserve(o, need + strlen(sep) + strlen(name) + 8);
+	switch (o->fmt) {
+	case OUT_FMT_TABLE:
+		n = strlen(sep);
+		memcpy(o->buf + o->len, sep, n);
+		o->len += n;
+		break;
+	case OUT_FMT_CSV:
+		if (o->field_cnt > 0)
+			o->buf[o->len++] = ',';
+		if (o->header) {
+			n = strlen(name);
+			memcpy(o->buf + o->len, name, n);
+			o->len += n;
+			o->field_cnt++;
+			return 0;
+		}
+		break;
+	case OUT_FMT_JSON:
+		o->buf[o->len++] = o->field_cnt > 0 ? ',' : '{';
+		o->buf[o->len++] = '"';
+		n = strlen(name);
+		memcpy(o->buf + o->len, name, n);
+		o->len += n;
+		o->buf[o->len++] = '"';
+		o->buf[o->len++] = ':';
+		break;
+	}
+	o->field_cnt++;
+	return 1;
+}
+
+// Plaats een al geformatteerde waarde, in de tabel-layout uitgelijnd op width.
+static inline void out_put_padded(out_t *o, const char *s, size_t n, int width) {
+	size_t w = width < 0 ? -width : width;
+	size_t pad = (o->fmt == OUT_FMT_TABLE && w > n) ? w - n : 0;
+
+	if (width > 0) {
+		memset(o->buf + o->len, ' ', pad);
+		o->len += pad;
+	}
+	memcpy(o->buf + o->len, s, n);
+	o->len += n;
+	if (width < 0) {
+		memset(o->buf + o->len, ' ', pad);
+		o->len += pad;
+	}
+}
+
+void out_rec_begin(out_t *o, int header) {
+	o->header    = header;
+	o->field_cnt = 0;
+}
+
+void out_rec_end(out_t *o) {
+	if (o->header && o->fmt != OUT_FMT_CSV)
+		return;
+	out_reserve(o, 3);
+	if (o->fmt == OUT_FMT_JSON) {
+		if (o->field_cnt == 0)
+			o->buf[o->len++] = '{';
+		o->buf[o->len++] = '}';
+	}
+	o->buf[o->len++] = '\n';
+}
+
+void out_str(out_t *o, const char *sep, const char *name, const char *val, int width) {
+	size_t n = strlen(val);
+	const unsigned char *s;
+	int quote;
+
+	if (!out_field_begin(o, sep, name, n * 6 + (width < 0 ? -width : width) + 2))
+		return;
+	switch (o->fmt) {
+	case OUT_FMT_TABLE:
+		out_put_padded(o, val, n, width);
+		break;
+	case OUT_FMT_CSV:
+		// RFC 4180: alleen quoten als het nodig is, een " wordt "".
+		quote = strpbrk(val, ",\"\r\n") != NULL;
+		if (quote)
+			o->buf[o->len++] = '"';
+		for (s=(const unsigned char *)val; *s; s++) {
+			if (*s == '"')
+				o->buf[o->len++] = '"';
+			o->buf[o->len++] = *s;
+		}
+		if (quote)
+			o->buf[o->len++] = '"';
+		break;
+	case OUT_FMT_JSON:
+		o->buf[o->len++] = '"';
+		for (s=(const unsigned char *)val; *s; s++) {
+			if (*s == '"' || *s == '\\') {
+				o->buf[o->len++] = '\\';
+				o->buf[o->len++] = *s;
+			} else if (*s < 0x20) {
+				o->len += sprintf(o->buf + o->len, "\\u%04x", *s);
+			} else {
+				o->buf[o->len++] = *s;
+			}
+		}
+		o->buf[o->len++] = '"';
+		break;
+	}
+}
+
+void out_long(out_t *o, const char *sep, const char *name, long val, int width) {
+	char num[OUT_NUM_LEN];
+	char *end = num + sizeof(num);
+	char *p;
+
+	if (!out_field_begin(o, sep, name, OUT_NUM_LEN + (width < 0 ? -width : width)))
+		return;
+	p = fmt_long(end, val);
+	out_put_padded(o, p, end - p, width);
+}
+
+// Een afgeleide waarde (geen hot path, dus gewoon via snprintf()).
+void out_double(out_t *o, const char *sep, const char *name, double val, int decimals, int width) {
+	char num[OUT_NUM_LEN];
+	int n;
+
+	if (!out_field_begin(o, sep, name, OUT_NUM_LEN + (width < 0 ? -width : width)))
+		return;
+	n = snprintf(num, sizeof(num), "%.*f", decimals, val);
+	if (n >= (int)sizeof(num))
+		n = sizeof(num) - 1;
+	out_put_padded(o, num, n, width);
+}
+
+// Een tijd in ticks als seconden met 2 decimalen, gelijk aan printf("%.2f", (float)ticks/ticks_per_sec).
+void out_ticks(out_t *o, const char *sep, const char *name, unsigned long long ticks, long ticks_per_sec, int width) {
+	char num[OUT_NUM_LEN];
+	char *end = num + sizeof(num);
+	char *p;
+
+	if (!out_field_begin(o, sep, name, OUT_NUM_LEN + (width < 0 ? -width : width)))
+		return;
+	p = fmt_fixed2(end, (float)ticks / ticks_per_sec);
+	out_put_padded(o, p, end - p, width);
+}
+
+#ifdef MODULE_TEST
+// Vergelijk out_ticks() met de oude printf("%.2f", (float)ticks/tps): alle ticks tot 10 miljoen
+// (daar zitten de meeste afrondingsgevallen), daarna in stappen van ongeveer 0.1% tot ver voorbij
+// 2^24 (waar de float de ticks zelf al niet meer exact bevat) en tot ULLONG_MAX.
+static unsigned long ticks_check(out_t *o, unsigned long long t, long tps, unsigned long *shown) {
+	char want[OUT_NUM_LEN];
+	int n;
+
+	o->len = 0;
+	out_ticks(o, "", "t", t, tps, 0);
+	n = snprintf(want, sizeof(want), "%.2f", (float)t / tps);
+	if ((size_t)n == o->len && memcmp(want, o->buf, n) == 0)
+		return 0;
+	if ((*shown)++ < 10)
+		printf("Verschil bij ticks %llu, tps %ld: \"%.*s\" i.p.v. \"%s\"\n", t, tps, (int)o->len, o->buf, want);
+	return 1;
+}
+
+int main(int argc, char **argv) {
+	static const long tps[] = { 100, 250, 1000 };
+	out_t *o = out_create(OUT_FMT_TABLE);
+	unsigned long checked = 0, failed = 0, shown = 0;
+	unsigned long long t;
+
+	for (int i=0; i<3; i++) {
+		for (t=0; t<10000000; t++, checked++)
+			failed += ticks_check(o, t, tps[i], &shown);
+		for (t=10000000; t < ~0ULL / 2; t += t / 1000 + 7, checked++)
+			failed += ticks_check(o, t, tps[i], &shown);
+		failed += ticks_check(o, ~0ULL, tps[i], &shown);
+		checked++;
+	}
+	o->len = 0;
+	out_destroy(o);
+	printf("out_ticks(): %lu waarden vergeleken, %lu verschillen\n", checked, failed);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif  // MODULE_TEST
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define OUT_BUF_SIZE     (256*1024)    // capaciteit van de output-buffer
+#define OUT_FIELD_MAX    512           // maximale lengte van één veld (incl. escapes)
+
+// Gebufferde output voor list_procs() en list_deltas().  De getallen worden zonder
+// printf() geformatteerd in een herbruikbare buffer, die met write() naar stdout gaat
+// zodra hij vol is of expliciet geflusht wordt (out_flush()).
+//
+// Een regel bestaat uit velden.  Per veld wordt meegegeven:
+//   - sep:   het scheidingsteken vóór het veld in de tabel-layout ("", " ", "  ", "|")
+//   - name:  de kolomnaam, voor de CSV-kopregel en de JSON-sleutels
+//   - width: de kolombreedte in de tabel-layout (negatief = links uitgelijnd, zoals %-40s)
+// In de CSV- en JSON-layout worden sep en width genegeerd.
+typedef enum {
+	OUT_FMT_TABLE,                 // de vaste kolommen van weleer (byte-identiek aan de printf-versie)
+	OUT_FMT_CSV,                   // kopregel met kolomnamen, daarna één regel per record
+	OUT_FMT_JSON                   // JSON Lines: één object per record
+} out_fmt_t;
+
+struct out {
+	out_fmt_t fmt;
+	int fd;                        // -1: gebruik fileno(stdout) (die kan na een SIGHUP veranderd zijn)
+	int header;                    // 1: de velden leveren hun naam i.p.v. hun waarde (CSV-kopregel)
+	int field_cnt;                 // aantal velden in het huidige record
+	size_t len;
+	size_t cap;
+	char *buf;
+};
+
+typedef struct out out_t;
+
+out_t * out_create(out_fmt_t fmt);
+void out_destroy(out_t *o);
+int out_parse_fmt(const char *s, out_fmt_t *fmt);
+void out_flush(out_t *o);
+void out_printf(out_t *o, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void out_rec_begin(out_t *o, int header);
+void out_rec_end(out_t *o);
+void out_str(out_t *o, const char *sep, const char *name, const char *val, int width);
+void out_long(out_t *o, const char *sep, const char *name, long val, int width);
+void out_double(out_t *o, const char *sep, const char *name, double val, int decimals, int width);
+void out_ticks(out_t *o, const char *sep, const char *name, unsigned long long ticks, long ticks_per_sec, int width);
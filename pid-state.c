@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "proc-sample.h"
+#include "proc-extra.h"
+#include "pid-state.h"
+
+/*
+ * Per-PID administratie voor delta-mode.
+ *
+ * Zonder deze administratie kan list_deltas() alleen de totalen van twee metingen
+ * van elkaar aftrekken.  Zodra er tussen twee metingen een proces stopt (of start)
+ * klopt dat verschil niet meer: de ticks van het gestopte proces tellen in de vorige
+ * meting wel mee en in de huidige niet.  Door per proces de vorige meting te bewaren
+ * kunnen we het verbruik per interval per proces berekenen, en tellen hoeveel processen
+ * er gestart en gestopt zijn en hoeveel geheugen de gestopte processen hebben vrijgegeven.
+ * Op dezelfde manier worden de cumulatieve tellers van -x (faults, context switches, I/O)
+ * per proces omgerekend naar de toename in het interval.
+ *
+ * De tabel is een open-addressing hashtabel met linear probing.  Een lookup kost
+ * gemiddeld O(1), ook met tienduizenden processen.  Verwijderde entries worden
+ * gemarkeerd als tombstone en bij een rehash opgeruimd.
+ */
+
+static unsigned long long pid_state_hashfn(int pid, unsigned long long start, int cmd_idx) {
+	unsigned long long h = ((unsigned long long) (unsigned int) pid << 32) ^ start ^ ((unsigned long long) cmd_idx << 56);
+
+	// splitmix64 finalizer
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+	return h;
+}
+
+static void pid_state_alloc_slots(pid_state_tab_t *tab, size_t size) {
+	if ((tab->slots = calloc(size, sizeof(pid_state_ent_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", size * sizeof(pid_state_ent_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	tab->size    = size;
+	tab->used    = 0;
+	tab->deleted = 0;
+}
+
+static pid_state_ent_t * pid_state_probe_free(pid_state_tab_t *tab, unsigned long long h) {
+	size_t mask = tab->size - 1;
+	size_t i    = h & mask;
+
+	while (tab->slots[i].slot_state == PID_SLOT_USED)
+		i = (i + 1) & mask;
+	return &tab->slots[i];
+}
+
+static void pid_state_rehash(pid_state_tab_t *tab, size_t new_size) {
+	pid_state_ent_t *old_slots = tab->slots;
+	size_t old_size = tab->size;
+	pid_state_ent_t *e;
+
+	pid_state_alloc_slots(tab, new_size);
+	for (size_t i=0; i<old_size; i++) {
+		if (old_slots[i].slot_state != PID_SLOT_USED)
+			continue;
+		e = pid_state_probe_free(tab, pid_state_hashfn(old_slots[i].pid, old_slots[i].start, old_slots[i].cmd_idx));
+		*e = old_slots[i];
+		tab->used++;
+	}
+	free(old_slots);
+}
+
+pid_state_tab_t * pid_state_create(size_t size) {
+	pid_state_tab_t *tab;
+	size_t s = 16;
+
+	while (s < size)
+		s *= 2;
+	if ((tab = malloc(sizeof(pid_state_tab_t))) == NULL) {
+		printf("ERROR - malloc(%ld) failed, %d - %s\n", sizeof(pid_state_tab_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	pid_state_alloc_slots(tab, s);
+	tab->generation = 0;
+	return tab;
+}
+
+// Tel de toename van de tellers van -x sinds de vorige meting op bij <d>, en onthoud de nieuwe stand.
+// Een teller die lager is dan de vorige keer (het lezen van status of io is mislukt) telt niet
+// mee en laat de vorige stand staan, zodat de volgende geslaagde meting niet alles dubbel telt.
+#define PID_STATE_COUNT(field) \
+	do { \
+		if (curr->field > prev->field) { \
+			d->field   += curr->field - prev->field; \
+			prev->field = curr->field; \
+		} \
+	} while (0)
+
+static void pid_state_extra_delta(extra_aggr_t *d, extra_aggr_t *prev, const extra_aggr_t *curr) {
+	PID_STATE_COUNT(minflt);
+	PID_STATE_COUNT(majflt);
+	PID_STATE_COUNT(nvcsw);
+	PID_STATE_COUNT(nivcsw);
+	PID_STATE_COUNT(read_bytes);
+	PID_STATE_COUNT(write_bytes);
+}
+
+void pid_state_destroy(pid_state_tab_t *tab) {
+	free(tab->slots);
+	free(tab);
+}
+
+// Markeer het begin van een nieuw interval.  Alle processen die in dit interval
+// niet via pid_state_update() worden aangemeld, worden door pid_state_sweep() als gestopt beschouwd.
+void pid_state_begin(pid_state_tab_t *tab) {
+	tab->generation++;
+}
+
+void pid_state_update(pid_state_tab_t *tab, int pid, unsigned long long start, int cmd_idx,
+                      unsigned long vsz, unsigned long rss,
+                      unsigned long long utime, unsigned long long stime, const extra_aggr_t *extra, pid_churn_t *churn) {
+	unsigned long long h;
+	size_t mask, i;
+	pid_state_ent_t *e, *tombstone = NULL;
+
+	// Houd de bezettingsgraad (inclusief tombstones) onder de 50%, zodat de probe-reeksen kort blijven.
+	if ((tab->used + tab->deleted + 1) * 2 > tab->size)
+		pid_state_rehash(tab, (tab->used + 1) * 4 > tab->size ? tab->size * 2 : tab->size);
+
+	h    = pid_state_hashfn(pid, start, cmd_idx);
+	mask = tab->size - 1;
+	i    = h & mask;
+	while (1) {
+		e = &tab->slots[i];
+		if (e->slot_state == PID_SLOT_EMPTY)
+			break;
+		if (e->slot_state == PID_SLOT_DELETED) {
+			if (!tombstone)
+				tombstone = e;
+		} else if (e->pid == pid && e->start == start && e->cmd_idx == cmd_idx) {
+			// Bekend proces: het verbruik in dit interval is het verschil met de vorige meting.
+			// De tellers van een levend proces lopen alleen op, maar we zijn voorzichtig.
+			churn->utime += utime > e->utime ? utime - e->utime : 0;
+			churn->stime += stime > e->stime ? stime - e->stime : 0;
+			e->vsz   = vsz;
+			e->rss   = rss;
+			e->utime = utime;
+			e->stime = stime;
+			if (extra)
+				pid_state_extra_delta(&churn->extra, &e->extra, extra);
+			e->generation = tab->generation;
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+
+	// Nieuw proces.  In het eerste interval is alles nieuw; dat is de nulmeting en telt niet mee.
+	// Daarna is een nieuw proces in dit interval gestart, dus al zijn ticks vallen in dit interval.
+	if (tab->generation > 1) {
+		churn->spawned += 1;
+		churn->utime   += utime;
+		churn->stime   += stime;
+	}
+	if (tombstone) {
+		e = tombstone;
+		tab->deleted--;
+	}
+	e->pid        = pid;
+	e->cmd_idx    = cmd_idx;
+	e->start      = start;
+	e->vsz        = vsz;
+	e->rss        = rss;
+	e->utime      = utime;
+	e->stime      = stime;
+	// De tellers van -x tellen pas vanaf de eerste meting van het proces; wat het daarvoor
+	// (mogelijk al jaren) verzameld heeft hoort niet bij dit interval.
+	if (extra)
+		e->extra  = *extra;
+	else
+		memset(&e->extra, 0, sizeof(extra_aggr_t));
+	e->generation = tab->generation;
+	e->slot_state = PID_SLOT_USED;
+	tab->used++;
+}
+
+// Verwijder alle processen die in het huidige interval niet meer gezien zijn,
+// en tel ze als gestopt bij het commando waar ze bij hoorden (als <churn> gezet is).
+void pid_state_sweep(pid_state_tab_t *tab, pid_churn_t churn[]) {
+	pid_state_ent_t *e;
+
+	for (size_t i=0; i<tab->size; i++) {
+		e = &tab->slots[i];
+		if (e->slot_state != PID_SLOT_USED || e->generation == tab->generation)
+			continue;
+		if (churn) {
+			churn[e->cmd_idx].exited       += 1;
+			churn[e->cmd_idx].vsz_released += e->vsz;
+			churn[e->cmd_idx].rss_released += e->rss;
+		}
+		e->slot_state = PID_SLOT_DELETED;
+		tab->used--;
+		tab->deleted++;
+	}
+
+	// Ruim de tombstones op wanneer ze een kwart van de tabel beslaan.
+	if (tab->deleted * 4 > tab->size)
+		pid_state_rehash(tab, tab->size);
+}
+
+#ifdef MODULE_TEST
+static int test_fail = 0;
+
+#define PID_STATE_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FOUT op regel %d: %s\n", __LINE__, #cond); \
+			test_fail++; \
+		} \
+	} while (0)
+
+// Eén interval: begin, de opgegeven processen aanmelden en de rest wegvegen.
+static void test_interval(pid_state_tab_t *tab, pid_churn_t *churn, int cnt, const int pid[],
+                          const unsigned long long start[], const unsigned long long utime[], const extra_aggr_t extra[]) {
+	memset(churn, 0, sizeof(pid_churn_t));
+	pid_state_begin(tab);
+	for (int i=0; i<cnt; i++)
+		pid_state_update(tab, pid[i], start[i], 0, 1000 + pid[i], 100 + pid[i], utime[i], 0,
+		                 extra ? &extra[i] : NULL, churn);
+	pid_state_sweep(tab, churn);
+}
+
+int main(int argc, char **argv) {
+	pid_state_tab_t *tab = pid_state_create(16);
+	pid_churn_t churn;
+	int pid[32];
+	unsigned long long start[32], utime[32];
+	extra_aggr_t extra[2];
+
+	// Nulmeting: twee processen, nog geen spawn of exit.
+	test_interval(tab, &churn, 2, (int []) { 100, 101 }, (unsigned long long []) { 10, 11 },
+	              (unsigned long long []) { 50, 60 }, NULL);
+	PID_STATE_CHECK(churn.spawned == 0 && churn.exited == 0 && churn.utime == 0);
+	PID_STATE_CHECK(tab->used == 2);
+
+	// 101 stopt, 102 start: 100 telt 5 ticks, 102 al zijn 7 ticks, 101 geeft zijn RSS vrij.
+	test_interval(tab, &churn, 2, (int []) { 100, 102 }, (unsigned long long []) { 10, 12 },
+	              (unsigned long long []) { 55, 7 }, NULL);
+	PID_STATE_CHECK(churn.spawned == 1 && churn.exited == 1);
+	PID_STATE_CHECK(churn.utime == 5 + 7);
+	PID_STATE_CHECK(churn.rss_released == 100 + 101 && churn.vsz_released == 1000 + 101);
+	PID_STATE_CHECK(tab->used == 2);
+
+	// PID 100 is hergebruikt (andere starttijd): het oude proces is gestopt, het nieuwe gestart.
+	test_interval(tab, &churn, 2, (int []) { 100, 102 }, (unsigned long long []) { 20, 12 },
+	              (unsigned long long []) { 3, 9 }, NULL);
+	PID_STATE_CHECK(churn.spawned == 1 && churn.exited == 1);
+	PID_STATE_CHECK(churn.utime == 3 + 2);
+	PID_STATE_CHECK(churn.rss_released == 100 + 100);
+	PID_STATE_CHECK(tab->used == 2);
+
+	// -x: een nieuw proces telt vanaf zijn eerste meting, een teller die terugvalt telt niet
+	// en laat de hoogste stand staan, zodat PID_STATE_COUNT nooit achteruit loopt.
+	memset(extra, 0, sizeof(extra));
+	extra[0].minflt = 1000;
+	extra[0].read_bytes = 4096;
+	test_interval(tab, &churn, 1, (int []) { 103 }, (unsigned long long []) { 30 },
+	              (unsigned long long []) { 0 }, extra);
+	PID_STATE_CHECK(churn.spawned == 1 && churn.exited == 2);
+	PID_STATE_CHECK(churn.extra.minflt == 0 && churn.extra.read_bytes == 0);
+	extra[0].minflt = 1010;
+	extra[0].read_bytes = 0;                     // io niet te lezen
+	test_interval(tab, &churn, 1, (int []) { 103 }, (unsigned long long []) { 30 },
+	              (unsigned long long []) { 0 }, extra);
+	PID_STATE_CHECK(churn.extra.minflt == 10 && churn.extra.read_bytes == 0);
+	extra[0].minflt = 1004;                      // terugval
+	extra[0].read_bytes = 8192;
+	test_interval(tab, &churn, 1, (int []) { 103 }, (unsigned long long []) { 30 },
+	              (unsigned long long []) { 0 }, extra);
+	PID_STATE_CHECK(churn.extra.minflt == 0 && churn.extra.read_bytes == 4096);
+	extra[0].minflt = 1012;
+	test_interval(tab, &churn, 1, (int []) { 103 }, (unsigned long long []) { 30 },
+	              (unsigned long long []) { 0 }, extra);
+	PID_STATE_CHECK(churn.extra.minflt == 2 && churn.extra.read_bytes == 0);
+	pid_state_destroy(tab);
+
+	// Tombstones: 20 processen in 64 slots, waarvan er 17 stoppen.  17 * 4 > 64, dus de sweep
+	// rehasht op dezelfde grootte; de 3 overgebleven processen moeten daarna nog gevonden worden.
+	tab = pid_state_create(64);
+	for (int i=0; i<20; i++) {
+		pid[i]   = 1000 + i;
+		start[i] = 500 + i;
+		utime[i] = 10;
+	}
+	test_interval(tab, &churn, 20, pid, start, utime, NULL);
+	PID_STATE_CHECK(tab->size == 64 && tab->used == 20 && tab->deleted == 0);
+	test_interval(tab, &churn, 3, pid, start, utime, NULL);
+	PID_STATE_CHECK(churn.exited == 17 && churn.spawned == 0);
+	PID_STATE_CHECK(tab->size == 64 && tab->used == 3 && tab->deleted == 0);
+	for (int i=0; i<3; i++)
+		utime[i] = 11;
+	test_interval(tab, &churn, 3, pid, start, utime, NULL);
+	PID_STATE_CHECK(churn.spawned == 0 && churn.exited == 0 && churn.utime == 3);
+	PID_STATE_CHECK(tab->size == 64 && tab->used == 3);
+
+	// Minder dan een kwart tombstones: geen rehash, de tombstones blijven staan.
+	test_interval(tab, &churn, 2, pid, start, utime, NULL);
+	PID_STATE_CHECK(churn.exited == 1 && tab->used == 2 && tab->deleted == 1);
+	pid_state_destroy(tab);
+
+	printf("pid-state: %s (%d fouten)\n", test_fail ? "NIET OK" : "OK", test_fail);
+	return test_fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif  // MODULE_TEST
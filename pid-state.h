@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Per-interval resultaten van de per-PID administratie, per commando (-c)
+struct pid_churn {
+        unsigned long      spawned;        // aantal processen dat sinds de vorige meting is gestart
+        unsigned long      exited;         // aantal processen dat sinds de vorige meting is gestopt
+        unsigned long long utime;          // user-ticks verbruikt in dit interval (alleen levende processen)
+        unsigned long long stime;          // system-ticks verbruikt in dit interval (alleen levende processen)
+        unsigned long      vsz_released;   // VSZ (KiB) van de gestopte processen bij hun laatste meting
+        unsigned long      rss_released;   // RSS (KiB) van de gestopte processen bij hun laatste meting
+        extra_aggr_t       extra;          // toename van de tellers van -x in dit interval (nlwp blijft 0)
+};
+
+// Slot in de open-addressing hashtabel.  De sleutel is (pid, start, cmd_idx):
+// een hergebruikt PID-nummer krijgt een andere starttijd en is dus een nieuw proces.
+struct pid_state_ent {
+        int                pid;
+        int                cmd_idx;
+        unsigned long long start;          // starttijd van het proces in ticks sinds boot
+        unsigned long      generation;     // laatste interval waarin het proces is gezien
+        unsigned long      vsz;
+        unsigned long      rss;
+        unsigned long long utime;
+        unsigned long long stime;
+        extra_aggr_t       extra;          // hoogste stand van de tellers van -x
+        unsigned char      slot_state;     // PID_SLOT_EMPTY, PID_SLOT_USED of PID_SLOT_DELETED
+};
+
+struct pid_state_tab {
+        struct pid_state_ent *slots;
+        size_t             size;           // aantal slots, altijd een macht van 2
+        size_t             used;           // aantal slots met status PID_SLOT_USED
+        size_t             deleted;        // aantal tombstones (PID_SLOT_DELETED)
+        unsigned long      generation;     // volgnummer van het huidige interval
+};
+
+typedef struct pid_churn     pid_churn_t;
+typedef struct pid_state_ent pid_state_ent_t;
+typedef struct pid_state_tab pid_state_tab_t;
+
+#define PID_SLOT_EMPTY   0
+#define PID_SLOT_USED    1
+#define PID_SLOT_DELETED 2
+#define PID_STATE_INITIAL_SIZE 1024
+
+pid_state_tab_t * pid_state_create(size_t size);
+void pid_state_destroy(pid_state_tab_t *tab);
+void pid_state_begin(pid_state_tab_t *tab);
+void pid_state_update(pid_state_tab_t *tab, int pid, unsigned long long start, int cmd_idx,
+                      unsigned long vsz, unsigned long rss,
+                      unsigned long long utime, unsigned long long stime, const extra_aggr_t *extra, pid_churn_t *churn);
+void pid_state_sweep(pid_state_tab_t *tab, pid_churn_t churn[]);
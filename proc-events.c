@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#include "proc-events.h"
+
+// Meld de socket aan (of af) bij de process connector.
+static int proc_events_mcast(int fd, enum proc_cn_mcast_op op) {
+	struct __attribute__((packed)) {
+		struct nlmsghdr         nlh;
+		struct cn_msg           cn;
+		enum proc_cn_mcast_op   op;
+	} req;
+
+	memset(&req, 0, sizeof(req));
+	req.nlh.nlmsg_len  = sizeof(req);
+	req.nlh.nlmsg_type = NLMSG_DONE;
+	req.cn.id.idx      = CN_IDX_PROC;
+	req.cn.id.val      = CN_VAL_PROC;
+	req.cn.len         = sizeof(req.op);
+	req.op             = op;
+	return send(fd, &req, sizeof(req), 0) == sizeof(req) ? 0 : -1;
+}
+
+proc_events_t * proc_events_create(void) {
+	struct sockaddr_nl addr = { .nl_family = AF_NETLINK, .nl_groups = CN_IDX_PROC };
+	int rcvbuf = PROC_EVENTS_RCVBUF;
+	proc_events_t *pe;
+
+	if ((pe = calloc(1, sizeof(proc_events_t))) == NULL ||
+	    (pe->ev = malloc(PROC_EVENTS_INITIAL_CAP * sizeof(proc_ev_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(proc_events_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	pe->cap = PROC_EVENTS_INITIAL_CAP;
+	if ((pe->fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR)) == -1 ||
+	    bind(pe->fd, (struct sockaddr *) &addr, sizeof(addr)) == -1 ||
+	    proc_events_mcast(pe->fd, PROC_CN_MCAST_LISTEN) == -1) {
+		printf("ERROR - failed to connect to the process connector (requires CAP_NET_ADMIN), %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	// Een ruime ontvangstbuffer, zodat een storm van fork()s tussen twee keer lezen niet
+	// meteen tot verloren events leidt.  SO_RCVBUFFORCE mag de limiet van de sysctl overschrijden.
+	if (setsockopt(pe->fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) == -1)
+		setsockopt(pe->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	return pe;
+}
+
+void proc_events_destroy(proc_events_t *pe) {
+	proc_events_mcast(pe->fd, PROC_CN_MCAST_IGNORE);
+	close(pe->fd);
+	free(pe->ev);
+	free(pe);
+}
+
+void proc_events_reset(proc_events_t *pe) {
+	pe->cnt  = 0;
+	pe->lost = 0;
+}
+
+static void proc_events_add(proc_events_t *pe, int type, int pid, int ppid) {
+	proc_ev_t *ev;
+
+	if (pe->cnt == pe->cap) {
+		if ((ev = realloc(pe->ev, pe->cap * 2 * sizeof(proc_ev_t))) == NULL) {
+			printf("ERROR - realloc(%ld) failed, %d - %s\n", pe->cap * 2 * sizeof(proc_ev_t), errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		pe->ev   = ev;
+		pe->cap *= 2;
+	}
+	pe->ev[pe->cnt].type = type;
+	pe->ev[pe->cnt].pid  = pid;
+	pe->ev[pe->cnt].ppid = ppid;
+	pe->cnt++;
+}
+
+// Lees alle events die klaarstaan (de socket is non-blocking) en voeg de relevante toe
+// aan pe->ev.  Wordt aangeroepen zodra de socket leesbaar is, dus ook tussen twee metingen.
+void proc_events_drain(proc_events_t *pe) {
+	struct nlmsghdr *nlh;
+	struct cn_msg *cn;
+	struct proc_event *ev;
+	ssize_t len;
+
+	while (1) {
+		if ((len = recv(pe->fd, pe->buf, sizeof(pe->buf), 0)) == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ENOBUFS) {
+				// De kernel heeft events weggegooid; de set gevolgde processen is niet meer volledig.
+				pe->lost = 1;
+				pe->lost_cnt++;
+				continue;
+			}
+			return;                    // EAGAIN: alles is gelezen
+		}
+		for (nlh = (struct nlmsghdr *) pe->buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == NLMSG_ERROR || nlh->nlmsg_type == NLMSG_NOOP)
+				continue;
+			cn = NLMSG_DATA(nlh);
+			if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC)
+				continue;
+			ev = (struct proc_event *) cn->data;
+			pe->total++;
+			switch (ev->what) {
+			case PROC_EVENT_FORK:
+				if (ev->event_data.fork.child_pid == ev->event_data.fork.child_tgid)
+					proc_events_add(pe, PROC_EV_FORK, ev->event_data.fork.child_pid, ev->event_data.fork.parent_tgid);
+				break;
+			case PROC_EVENT_EXEC:
+				proc_events_add(pe, PROC_EV_EXEC, ev->event_data.exec.process_tgid, 0);
+				break;
+			case PROC_EVENT_COMM:
+				if (ev->event_data.comm.process_pid == ev->event_data.comm.process_tgid)
+					proc_events_add(pe, PROC_EV_COMM, ev->event_data.comm.process_pid, 0);
+				break;
+			case PROC_EVENT_UID:
+				if (ev->event_data.id.process_pid == ev->event_data.id.process_tgid)
+					proc_events_add(pe, PROC_EV_UID, ev->event_data.id.process_pid, 0);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define PROC_EVENTS_BUF_SIZE    65536
+#define PROC_EVENTS_INITIAL_CAP 1024
+#define PROC_EVENTS_RCVBUF      (8*1024*1024)
+#define PROC_EVENTS_RESCAN      300     // standaard -D bij -e: volledige enumeratie als controle
+
+#define PROC_EV_FORK 1                  // nieuw proces (ppid is de ouder)
+#define PROC_EV_EXEC 2                  // het proces voert een ander programma uit
+#define PROC_EV_COMM 3                  // de naam van het proces is veranderd (prctl(PR_SET_NAME))
+#define PROC_EV_UID  4                  // de uid van het proces is veranderd
+
+// Process-events van de kernel (optie -e), via de process connector (NETLINK_CONNECTOR,
+// CN_IDX_PROC).  Daarmee wordt de set gevolgde processen van proc-track.c tussen twee
+// volledige enumeraties bijgehouden: een nieuw proces hoeft niet meer te wachten op de
+// volgende enumeratie, en die is alleen nog nodig bij de start, als periodieke controle
+// (-D) en wanneer er events verloren zijn gegaan.  De kosten per meting hangen dan af van
+// het aantal events en gevolgde processen, niet meer van het aantal processen op de machine.
+//
+// Alleen processen worden doorgegeven, geen threads.  Het stoppen van processen hoeft niet
+// doorgegeven te worden: proc_track_sample() merkt dat zelf (ESRCH).  De socket vereist
+// CAP_NET_ADMIN.  Loopt de ontvangstbuffer van de socket vol, dan gooit de kernel events
+// weg (ENOBUFS); lost wordt dan gezet en de aanroeper moet opnieuw enumereren.
+typedef struct proc_ev {
+	int type;                          // PROC_EV_*
+	int pid;
+	int ppid;                          // alleen bij PROC_EV_FORK
+} proc_ev_t;
+
+struct proc_events {
+	int fd;
+	proc_ev_t *ev;                     // de events sinds de laatste proc_events_reset()
+	size_t cnt;
+	size_t cap;
+	int lost;                          // er zijn events verloren gegaan sinds de laatste reset
+	unsigned long total;               // aantal ontvangen events sinds de start
+	unsigned long lost_cnt;            // aantal keren dat er events verloren gingen
+	char buf[PROC_EVENTS_BUF_SIZE];
+};
+
+typedef struct proc_events proc_events_t;
+
+proc_events_t * proc_events_create(void);
+void proc_events_destroy(proc_events_t *pe);
+void proc_events_drain(proc_events_t *pe);
+void proc_events_reset(proc_events_t *pe);
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE    // voor memmem()
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "proc-sample.h"
+#include "proc-extra.h"
+
+// Parse de klassen van -x: een komma-gescheiden lijst van flt, ctx, io en thr, of all.
+int proc_extra_parse(const char *s, unsigned int *classes) {
+	static const struct { const char *name; unsigned int bit; } cls[] = {
+		{ "flt", PROC_EXTRA_FLT }, { "ctx", PROC_EXTRA_CTX }, { "io", PROC_EXTRA_IO }, { "thr", PROC_EXTRA_THR },
+		{ "all", PROC_EXTRA_FLT | PROC_EXTRA_CTX | PROC_EXTRA_IO | PROC_EXTRA_THR },
+	};
+	const char *end;
+	size_t len, k;
+
+	do {
+		end = strchr(s, ',');
+		len = end ? (size_t) (end - s) : strlen(s);
+		for (k=0; k<sizeof(cls)/sizeof(cls[0]); k++) {
+			if (strlen(cls[k].name) == len && strncmp(cls[k].name, s, len) == 0)
+				break;
+		}
+		if (k == sizeof(cls)/sizeof(cls[0]))
+			return -1;
+		*classes |= cls[k].bit;
+		s = end + 1;
+	} while (end);
+	return 0;
+}
+
+proc_extra_t * proc_extra_create(void) {
+	proc_extra_t *pe;
+
+	if ((pe = calloc(1, sizeof(proc_extra_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(proc_extra_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if ((pe->proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		printf("ERROR - open(/proc) failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return pe;
+}
+
+void proc_extra_destroy(proc_extra_t *pe) {
+	close(pe->proc_fd);
+	free(pe);
+}
+
+// Lees /proc/PID/<file> in pe->buf (afgesloten met een '\0').  Geeft de lengte terug, of -1.
+static ssize_t proc_extra_load(proc_extra_t *pe, int pid, const char *file) {
+	char name[48];
+	ssize_t len;
+	int fd;
+
+	snprintf(name, sizeof(name), "%d/%s", pid, file);
+	if ((fd = openat(pe->proc_fd, name, O_RDONLY | O_CLOEXEC)) == -1) {
+		pe->fail_cnt++;
+		return -1;
+	}
+	len = read(fd, pe->buf, sizeof(pe->buf) - 1);
+	close(fd);
+	if (len <= 0) {
+		pe->fail_cnt++;
+		return -1;
+	}
+	pe->buf[len] = '\0';
+	pe->read_cnt++;
+	return len;
+}
+
+// Zoek "\n<key>" op en geef het getal erachter (na de ':' en witruimte), of 0.
+// <buf> moet met een '\0' afgesloten zijn.
+static unsigned long proc_extra_field(const char *buf, size_t len, const char *key) {
+	const char *p = memmem(buf, len, key, strlen(key));
+
+	return p ? strtoul(p + strlen(key), NULL, 10) : 0;
+}
+
+// Haal de context switches uit de inhoud van /proc/PID/status (ook gebruikt door proc-track.c).
+void proc_extra_parse_status(const char *buf, size_t len, PROC_SAMPLES *ps, size_t j) {
+	ps->nvcsw[j]  = proc_extra_field(buf, len, "\nvoluntary_ctxt_switches:");
+	ps->nivcsw[j] = proc_extra_field(buf, len, "\nnonvoluntary_ctxt_switches:");
+}
+
+// Haal de gelezen en geschreven bytes uit de inhoud van /proc/PID/io.
+void proc_extra_parse_io(const char *buf, size_t len, PROC_SAMPLES *ps, size_t j) {
+	ps->read_bytes[j]  = proc_extra_field(buf, len, "\nread_bytes:");
+	ps->write_bytes[j] = proc_extra_field(buf, len, "\nwrite_bytes:");
+}
+
+// Lees de klassen uit <classes> voor sample <j>.  Een proces dat gestopt is, of waarvan we de
+// files niet mogen lezen, telt voor die klassen als 0.
+void proc_extra_read(proc_extra_t *pe, PROC_SAMPLES *ps, size_t j, unsigned int classes) {
+	ssize_t len;
+
+	if (classes & PROC_EXTRA_CTX) {
+		ps->nvcsw[j] = ps->nivcsw[j] = 0;
+		if ((len = proc_extra_load(pe, ps->pid[j], "status")) > 0)
+			proc_extra_parse_status(pe->buf, len, ps, j);
+	}
+	if (classes & PROC_EXTRA_IO) {
+		ps->read_bytes[j] = ps->write_bytes[j] = 0;
+		if ((len = proc_extra_load(pe, ps->pid[j], "io")) > 0)
+			proc_extra_parse_io(pe->buf, len, ps, j);
+	}
+}
+
+void extra_aggr_add(extra_aggr_t *a, PROC_SAMPLES *ps, size_t j) {
+	a->minflt      += ps->minflt[j];
+	a->majflt      += ps->majflt[j];
+	a->nvcsw       += ps->nvcsw[j];
+	a->nivcsw      += ps->nivcsw[j];
+	a->read_bytes  += ps->read_bytes[j];
+	a->write_bytes += ps->write_bytes[j];
+	a->nlwp        += ps->nlwp[j];
+}
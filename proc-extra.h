@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define PROC_EXTRA_BUF_SIZE 4096       // /proc/PID/status is ongeveer 1500 bytes
+
+#define PROC_EXTRA_FLT 0x01            // minor en major page faults
+#define PROC_EXTRA_CTX 0x02            // vrijwillige en onvrijwillige context switches
+#define PROC_EXTRA_IO  0x04            // gelezen en geschreven bytes (storage)
+#define PROC_EXTRA_THR 0x08            // aantal threads
+
+// Extra metingen per commando (optie -x), per klasse aan te zetten zodat je alleen betaalt
+// voor wat je vraagt.  De faults en het aantal threads staan in /proc/PID/stat en worden in
+// dezelfde leesactie meegenomen als vsz, rss en de CPU-tijd.  De bytes van /proc/PID/io levert
+// libproc2 in dezelfde doorloop; alleen in de goedkope sample-modus (-D, -e) worden die hier
+// gelezen.  De context switches levert libproc2 niet; die komen altijd uit /proc/PID/status,
+// dus -x ctx kost één extra read per proces.  /proc/PID/io vereist dezelfde rechten als ptrace.
+typedef struct extra_aggr {
+	unsigned long minflt;
+	unsigned long majflt;
+	unsigned long nvcsw;               // voluntary_ctxt_switches
+	unsigned long nivcsw;              // nonvoluntary_ctxt_switches
+	unsigned long read_bytes;
+	unsigned long write_bytes;
+	unsigned long nlwp;                // aantal threads
+} extra_aggr_t;
+
+struct proc_extra {
+	int proc_fd;                       // open directory /proc/ (voor openat())
+	unsigned long read_cnt;            // aantal gelezen files sinds de start
+	unsigned long fail_cnt;            // aantal niet leesbare (gestopt, of geen rechten)
+	char buf[PROC_EXTRA_BUF_SIZE];
+};
+
+typedef struct proc_extra proc_extra_t;
+
+int  proc_extra_parse(const char *s, unsigned int *classes);
+proc_extra_t * proc_extra_create(void);
+void proc_extra_destroy(proc_extra_t *pe);
+void proc_extra_read(proc_extra_t *pe, PROC_SAMPLES *ps, size_t j, unsigned int classes);
+void proc_extra_parse_status(const char *buf, size_t len, PROC_SAMPLES *ps, size_t j);
+void proc_extra_parse_io(const char *buf, size_t len, PROC_SAMPLES *ps, size_t j);
+void extra_aggr_add(extra_aggr_t *a, PROC_SAMPLES *ps, size_t j);
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Generator van een synthetische /proc-boom voor de benchmarks (zie sock-bench.c).
+ *
+ * Maakt onder <dir> het volgende aan:
+ *   <dir>/<pid>/comm           "fixture" (elke tiende PID "other", die niet gematcht wordt)
+ *   <dir>/<pid>/fd/<n>         symlinks naar "socket:[ino]", <fds> per PID
+ *   <dir>/net/tcp              <tcp> regels in het formaat van de kernel
+ *   <dir>/net/{tcp6,udp,udp6,unix}   alleen de kopregel
+ *
+ * De inode-nummers van de fd's lopen rond over die van net/tcp; zijn er meer fd's dan
+ * regels, dan komt een deel van de sockets niet in de hash-table voor, zoals in het echt
+ * (bv. netlink-sockets).  Met PROC_ROOT=<dir>/ en PROC_TCP=<dir>/net/tcp (enz.) lezen
+ * inode-stats.c, proc-track.c en smaps-stats.c deze boom in plaats van /proc.
+ *
+ * Gebruik: ./proc-fixture <dir> <aantal pids> <fds per pid> <regels in tcp>
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define FIXTURE_PID_BASE 100000
+#define FIXTURE_INO_BASE 1000000
+
+static void fixture_mkdir(const char *path) {
+	if (mkdir(path, 0755) == -1) {
+		printf("ERROR - mkdir(%s) failed, %d - %s\n", path, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+static FILE * fixture_fopen(const char *path) {
+	FILE *fp;
+
+	if ((fp = fopen(path, "w")) == NULL) {
+		printf("ERROR - fopen(%s, \"w\") failed, %d - %s\n", path, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return fp;
+}
+
+static void fixture_header(const char *dir, const char *name, const char *header) {
+	char path[4096];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/net/%s", dir, name);
+	fp = fixture_fopen(path);
+	fputs(header, fp);
+	fclose(fp);
+}
+
+int main(int argc, char **argv) {
+	// ESTABLISHED, CLOSE_WAIT, LISTEN en TIME_WAIT (die laatste zonder owner, dus met inode 0)
+	static const unsigned int states[] = { 0x01, 0x01, 0x01, 0x08, 0x0A, 0x06 };
+	static const char tcp_header[] =
+		"  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n";
+	char path[4096], lnk[64];
+	long pids, fds, tcp, i, k;
+	unsigned int state;
+	FILE *fp;
+
+	if (argc != 5 || (pids = atol(argv[2])) <= 0 || (fds = atol(argv[3])) < 0 || (tcp = atol(argv[4])) < 0) {
+		fprintf(stderr, "usage: %s <dir> <pids> <fds per pid> <tcp lines>\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	fixture_mkdir(argv[1]);
+	snprintf(path, sizeof(path), "%s/net", argv[1]);
+	fixture_mkdir(path);
+
+	snprintf(path, sizeof(path), "%s/net/tcp", argv[1]);
+	fp = fixture_fopen(path);
+	fputs(tcp_header, fp);
+	for (i=0; i<tcp; i++) {
+		state = states[i % (sizeof(states) / sizeof(states[0]))];
+		fprintf(fp, "%6ld: 0100007F:%04lX 0200007F:%04lX %02X 00000000:00000000 00:00000000 00000000  %5ld        0 %lu 1 0000000000000000 20 4 30 10 -1\n",
+		        i, 1024 + i % 60000, 30000 + i % 30000, state, 1000 + i % 100,
+		        state == 0x06 ? 0 : FIXTURE_INO_BASE + i);
+	}
+	fclose(fp);
+	fixture_header(argv[1], "tcp6", tcp_header);
+	fixture_header(argv[1], "udp", tcp_header);
+	fixture_header(argv[1], "udp6", tcp_header);
+	fixture_header(argv[1], "unix", "Num       RefCount Protocol Flags    Type St Inode Path\n");
+
+	for (i=0; i<pids; i++) {
+		snprintf(path, sizeof(path), "%s/%ld", argv[1], FIXTURE_PID_BASE + i);
+		fixture_mkdir(path);
+		snprintf(path, sizeof(path), "%s/%ld/comm", argv[1], FIXTURE_PID_BASE + i);
+		fp = fixture_fopen(path);
+		fputs(i % 10 == 9 ? "other\n" : "fixture\n", fp);
+		fclose(fp);
+		snprintf(path, sizeof(path), "%s/%ld/fd", argv[1], FIXTURE_PID_BASE + i);
+		fixture_mkdir(path);
+		for (k=0; k<fds; k++) {
+			snprintf(path, sizeof(path), "%s/%ld/fd/%ld", argv[1], FIXTURE_PID_BASE + i, k);
+			snprintf(lnk, sizeof(lnk), "socket:[%lu]", FIXTURE_INO_BASE + (tcp > 0 ? (i * fds + k) % tcp : i * fds + k));
+			if (symlink(lnk, path) == -1) {
+				printf("ERROR - symlink(%s) failed, %d - %s\n", path, errno, strerror(errno));
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+	printf("%s: %ld pids, %ld fds per pid, %ld tcp lines\n", argv[1], pids, fds, tcp);
+	exit(EXIT_SUCCESS);
+}
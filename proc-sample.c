@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "proc-sample.h"
+
+static void * proc_samples_grow_array(void *ptr, size_t elem_size, size_t cap) {
+	void *p;
+
+	if ((p = realloc(ptr, elem_size * cap)) == NULL) {
+		printf("ERROR - realloc(%ld) failed, %d - %s\n", elem_size * cap, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+static void proc_samples_grow(PROC_SAMPLES *ps, size_t cap) {
+	ps->vsz   = proc_samples_grow_array(ps->vsz,   sizeof(ps->vsz[0]),   cap);
+	ps->rss   = proc_samples_grow_array(ps->rss,   sizeof(ps->rss[0]),   cap);
+	ps->utime = proc_samples_grow_array(ps->utime, sizeof(ps->utime[0]), cap);
+	ps->stime = proc_samples_grow_array(ps->stime, sizeof(ps->stime[0]), cap);
+	ps->start = proc_samples_grow_array(ps->start, sizeof(ps->start[0]), cap);
+	ps->minflt      = proc_samples_grow_array(ps->minflt,      sizeof(ps->minflt[0]),      cap);
+	ps->majflt      = proc_samples_grow_array(ps->majflt,      sizeof(ps->majflt[0]),      cap);
+	ps->nvcsw       = proc_samples_grow_array(ps->nvcsw,       sizeof(ps->nvcsw[0]),       cap);
+	ps->nivcsw      = proc_samples_grow_array(ps->nivcsw,      sizeof(ps->nivcsw[0]),      cap);
+	ps->read_bytes  = proc_samples_grow_array(ps->read_bytes,  sizeof(ps->read_bytes[0]),  cap);
+	ps->write_bytes = proc_samples_grow_array(ps->write_bytes, sizeof(ps->write_bytes[0]), cap);
+	ps->nlwp        = proc_samples_grow_array(ps->nlwp,        sizeof(ps->nlwp[0]),        cap);
+	ps->pid   = proc_samples_grow_array(ps->pid,   sizeof(ps->pid[0]),   cap);
+	ps->ppid  = proc_samples_grow_array(ps->ppid,  sizeof(ps->ppid[0]),  cap);
+	ps->tgid  = proc_samples_grow_array(ps->tgid,  sizeof(ps->tgid[0]),  cap);
+	ps->euid  = proc_samples_grow_array(ps->euid,  sizeof(ps->euid[0]),  cap);
+	ps->cmd   = proc_samples_grow_array(ps->cmd,   sizeof(ps->cmd[0]),   cap);
+	ps->cap   = cap;
+	ps->alloc_cnt++;
+}
+
+PROC_SAMPLES * proc_samples_create(size_t cap) {
+	PROC_SAMPLES *ps;
+
+	if ((ps = calloc(1, sizeof(PROC_SAMPLES))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(PROC_SAMPLES), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	proc_samples_grow(ps, cap > 0 ? cap : PROC_SAMPLES_INITIAL_CAP);
+	return ps;
+}
+
+void proc_samples_destroy(PROC_SAMPLES *ps) {
+	free(ps->vsz);
+	free(ps->rss);
+	free(ps->utime);
+	free(ps->stime);
+	free(ps->start);
+	free(ps->minflt);
+	free(ps->majflt);
+	free(ps->nvcsw);
+	free(ps->nivcsw);
+	free(ps->read_bytes);
+	free(ps->write_bytes);
+	free(ps->nlwp);
+	free(ps->pid);
+	free(ps->ppid);
+	free(ps->tgid);
+	free(ps->euid);
+	free(ps->cmd);
+	free(ps);
+}
+
+// Maak de buffer leeg voor een nieuw interval.  Het geheugen blijft behouden.
+void proc_samples_reset(PROC_SAMPLES *ps) {
+	ps->cnt = 0;
+}
+
+// Reserveer het volgende sample en geef de index ervan terug.
+// De buffer verdubbelt alleen wanneer hij vol is, dus het aantal allocaties
+// is logaritmisch in het grootste aantal processen dat ooit is gezien.
+size_t proc_samples_add(PROC_SAMPLES *ps) {
+	if (ps->cnt == ps->cap)
+		proc_samples_grow(ps, ps->cap * 2);
+	return ps->cnt++;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define PROC_SAMPLE_STR_LEN (64+1)
+
+// Sample-buffer voor de procesgegevens van één interval.
+//
+// De buffer wordt éénmalig gealloceerd en elk interval hergebruikt (proc_samples_reset()).
+// Alleen wanneer er meer processen zijn dan ooit tevoren groeit de buffer; in de
+// steady state doet de meet-loop dus geen enkele heap-allocatie.
+// De numerieke velden staan als struct-of-arrays opgeslagen, zodat de aggregatie
+// in delta-mode aaneengesloten geheugen doorloopt.
+typedef struct proc_samples {
+	size_t cnt;                        // aantal gevulde samples in dit interval
+	size_t cap;                        // capaciteit van de arrays
+	unsigned long alloc_cnt;           // aantal (her)allocaties sinds de start
+	unsigned long *vsz;                // KiB
+	unsigned long *rss;                // KiB
+	unsigned long long *utime;         // ticks
+	unsigned long long *stime;         // ticks
+	unsigned long long *start;         // starttijd in ticks sinds boot
+	unsigned long *minflt;             // de velden van -x (zie proc-extra.h)
+	unsigned long *majflt;
+	unsigned long *nvcsw;
+	unsigned long *nivcsw;
+	unsigned long *read_bytes;
+	unsigned long *write_bytes;
+	unsigned long *nlwp;
+	int *pid;
+	int *ppid;
+	int *tgid;
+	unsigned int *euid;
+	char (*cmd)[PROC_SAMPLE_STR_LEN];
+} PROC_SAMPLES;
+
+#define PROC_SAMPLES_INITIAL_CAP 1024
+
+PROC_SAMPLES * proc_samples_create(size_t cap);
+void   proc_samples_destroy(PROC_SAMPLES *ps);
+void   proc_samples_reset(PROC_SAMPLES *ps);
+size_t proc_samples_add(PROC_SAMPLES *ps);
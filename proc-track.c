@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE    // voor memrchr()
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "proc-sample.h"
+#include "proc-extra.h"
+#include "proc-track.h"
+
+// Het aantal fd's dat open mag blijven: de limiet van het proces min een vaste reserve voor
+// de rest van het programma (-s, -M, -g, -P, libproc2).  Een onbeperkte of zeer ruime limiet
+// wordt begrensd op PROC_TRACK_FD_MAX.
+static long proc_track_fd_budget(void) {
+	struct rlimit rl;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) == -1 || rl.rlim_cur == RLIM_INFINITY)
+		return PROC_TRACK_FD_MAX;
+	if (rl.rlim_cur > PROC_TRACK_FD_MAX)
+		rl.rlim_cur = PROC_TRACK_FD_MAX;
+	return (long) rl.rlim_cur > PROC_TRACK_FD_RESERVE ? (long) rl.rlim_cur - PROC_TRACK_FD_RESERVE : 0;
+}
+
+// <extra>: de klassen van -x waarvan de files per proces open moeten blijven (ctx, io).
+proc_track_t * proc_track_create(unsigned int extra) {
+	const char *root = getenv("PROC_ROOT") ? : "/proc/";
+	proc_track_t *pt;
+
+	if ((pt = calloc(1, sizeof(proc_track_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(proc_track_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if ((pt->proc_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		printf("ERROR - failed to open %s, %d - %s\n", root, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	pt->page_kib = sysconf(_SC_PAGESIZE) / 1024;
+	pt->extra    = extra & (PROC_EXTRA_CTX | PROC_EXTRA_IO);
+	pt->fd_budget = proc_track_fd_budget();
+	return pt;
+}
+
+static void proc_track_close_fd(proc_track_t *pt, int *fd) {
+	if (*fd != -1) {
+		close(*fd);
+		pt->fd_kept--;
+	}
+	*fd = -1;
+}
+
+// Sluit de open files van een proces.
+void proc_track_close(proc_track_t *pt, proc_track_ent_t *e) {
+	proc_track_close_fd(pt, &e->fd);
+	proc_track_close_fd(pt, &e->fd_status);
+	proc_track_close_fd(pt, &e->fd_io);
+}
+
+static void proc_track_close_all(proc_track_t *pt) {
+	for (size_t i=0; i<pt->cnt; i++)
+		proc_track_close(pt, &pt->ent[i]);
+	pt->cnt = 0;
+}
+
+void proc_track_destroy(proc_track_t *pt) {
+	proc_track_close_all(pt);
+	close(pt->proc_fd);
+	if (pt->probe)
+		proc_samples_destroy(pt->probe);
+	free(pt->ent);
+	free(pt);
+}
+
+static int proc_track_open(proc_track_t *pt, int pid, const char *file) {
+	char name[32];
+
+	snprintf(name, sizeof(name), "%d/%s", pid, file);
+	return openat(pt->proc_fd, name, O_RDONLY | O_CLOEXEC);
+}
+
+// Open een file die open blijft, zolang het budget (pt->fd_budget) dat toelaat.  Daarboven
+// blijft de fd -1 en wordt de file per meting geopend en weer gesloten (proc_track_load()).
+static int proc_track_keep(proc_track_t *pt, int pid, const char *file) {
+	int fd;
+
+	if (pt->fd_kept >= pt->fd_budget)
+		return -1;
+	if ((fd = proc_track_open(pt, pid, file)) != -1)
+		pt->fd_kept++;
+	return fd;
+}
+
+// Open de files van -x ctx en io die open blijven (binnen het budget).
+static void proc_track_open_extra(proc_track_t *pt, proc_track_ent_t *e) {
+	e->fd_status = pt->extra & PROC_EXTRA_CTX ? proc_track_keep(pt, e->pid, "status") : -1;
+	e->fd_io     = pt->extra & PROC_EXTRA_IO ? proc_track_keep(pt, e->pid, "io") : -1;
+}
+
+// Open de files van een proces: stat altijd, status en io alleen voor -x ctx en io.
+static void proc_track_open_all(proc_track_t *pt, proc_track_ent_t *e) {
+	e->fd = proc_track_keep(pt, e->pid, "stat");
+	proc_track_open_extra(pt, e);
+}
+
+static int proc_track_cmp(const void *a, const void *b) {
+	return ((const proc_track_ent_t *) a)->pid - ((const proc_track_ent_t *) b)->pid;
+}
+
+// Vervang de set gevolgde processen door de processen in <ps> (het resultaat van een
+// volledige enumeratie, al gefilterd op -c/-u).  Boven het budget van open files worden
+// de files van de overige processen per meting geopend.
+void proc_track_rebuild(proc_track_t *pt, PROC_SAMPLES *ps) {
+	proc_track_ent_t *e;
+
+	proc_track_close_all(pt);
+	if (ps->cnt > pt->cap) {
+		if ((e = realloc(pt->ent, ps->cnt * sizeof(proc_track_ent_t))) == NULL) {
+			printf("ERROR - realloc(%ld) failed, %d - %s\n", ps->cnt * sizeof(proc_track_ent_t), errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		pt->ent = e;
+		pt->cap = ps->cnt;
+	}
+	for (size_t j=0; j<ps->cnt; j++) {
+		e = &pt->ent[j];
+		e->pid   = ps->pid[j];
+		e->ppid  = ps->ppid[j];
+		e->tgid  = ps->tgid[j];
+		e->euid  = ps->euid[j];
+		e->start = ps->start[j];
+		e->alive = 1;
+		e->fd    = proc_track_keep(pt, e->pid, "stat");
+	}
+	// Eerst stat voor alle processen; status en io krijgen alleen wat er van het budget over
+	// is, zodat -x ctx,io het aantal processen met een open stat-file niet verkleint.
+	for (size_t j=0; j<ps->cnt && pt->extra; j++)
+		proc_track_open_extra(pt, &pt->ent[j]);
+	pt->cnt  = ps->cnt;
+	pt->gone = 0;
+	pt->fd_short = 0;
+	qsort(pt->ent, pt->cnt, sizeof(proc_track_ent_t), proc_track_cmp);
+}
+
+// Lees een decimaal getal en het scheidingsteken erachter.
+static unsigned long long proc_track_parse_num(char **pp, char *end) {
+	unsigned long long val = 0;
+	char *p = *pp;
+
+	if (p < end && *p == '-')      // negatieve velden (bv. tpgid) slaan we alleen over
+		p++;
+	while (p < end && (unsigned) (*p - '0') < 10)
+		val = val * 10 + (*p++ - '0');
+	*pp = p + 1;
+	return val;
+}
+
+// Sla <n> spatie-gescheiden velden over.
+static char * proc_track_skip(char *p, char *end, int n) {
+	while (n-- > 0) {
+		while (p < end && *p != ' ')
+			p++;
+		p++;
+	}
+	return p;
+}
+
+// Parse de inhoud van /proc/PID/stat in sample <j> van <ps>.  Zie proc(5):
+//   pid (comm) state ppid ... minflt(10) majflt(12) utime(14) stime(15) ... num_threads(20)
+//   starttime(22) vsize(23) rss(24) ...
+// comm kan spaties en haakjes bevatten, dus we zoeken vanaf het laatste ')'.
+static int proc_track_parse(proc_track_t *pt, char *buf, size_t len, PROC_SAMPLES *ps, size_t j) {
+	char *end = buf + len;
+	char *open  = memchr(buf, '(', len);
+	char *close = memrchr(buf, ')', len);
+	size_t comm_len;
+	char *p;
+
+	if (!open || !close || close < open || close + 2 >= end)
+		return -1;
+	comm_len = close - open - 1;
+	if (comm_len > PROC_SAMPLE_STR_LEN - 1)
+		comm_len = PROC_SAMPLE_STR_LEN - 1;
+	memcpy(ps->cmd[j], open + 1, comm_len);
+	ps->cmd[j][comm_len] = '\0';
+
+	p = proc_track_skip(close + 2, end, 1);                       // veld 4
+	ps->ppid[j]   = proc_track_parse_num(&p, end);
+	p = proc_track_skip(p, end, 5);                               // veld 10
+	ps->minflt[j] = proc_track_parse_num(&p, end);
+	p = proc_track_skip(p, end, 1);                               // veld 12
+	ps->majflt[j] = proc_track_parse_num(&p, end);
+	p = proc_track_skip(p, end, 1);                               // veld 14
+	ps->utime[j]  = proc_track_parse_num(&p, end);
+	ps->stime[j]  = proc_track_parse_num(&p, end);
+	p = proc_track_skip(p, end, 4);                               // veld 20
+	ps->nlwp[j]   = proc_track_parse_num(&p, end);
+	p = proc_track_skip(p, end, 1);                               // veld 22
+	ps->start[j]  = proc_track_parse_num(&p, end);
+	ps->vsz[j]    = proc_track_parse_num(&p, end) / 1024;          // bytes -> KiB
+	ps->rss[j]    = proc_track_parse_num(&p, end) * pt->page_kib;  // pagina's -> KiB
+	return p <= end ? 0 : -1;
+}
+
+// Lees /proc/PID/<file> via de open <fd>, of (geen fd) via een open/read/close, in pt->buf.
+// De inhoud wordt afgesloten met een '\0'.  Geeft de lengte terug, of -1.  Is er geen fd
+// meer vrij (EMFILE/ENFILE), dan wordt dat geteld en pt->fd_short gezet: de meting is dan
+// onvolledig en de aanroeper moet een volledige enumeratie doen.
+static ssize_t proc_track_load(proc_track_t *pt, int fd, int pid, const char *file) {
+	ssize_t len;
+
+	if (fd != -1) {
+		len = pread(fd, pt->buf, sizeof(pt->buf) - 1, 0);
+	} else if ((fd = proc_track_open(pt, pid, file)) != -1) {
+		len = read(fd, pt->buf, sizeof(pt->buf) - 1);
+		close(fd);
+	} else {
+		if (errno == EMFILE || errno == ENFILE) {
+			pt->fd_short = 1;
+			pt->fd_fail++;
+		}
+		return -1;
+	}
+	if (len <= 0)
+		return -1;
+	pt->buf[len] = '\0';
+	return len;
+}
+
+// Lees de klassen van -x die niet in /proc/PID/stat staan.  Een file die we niet kunnen
+// lezen (geen rechten, of het proces is net gestopt) telt als 0, net als in proc_extra_read().
+static void proc_track_extra(proc_track_t *pt, proc_track_ent_t *e, PROC_SAMPLES *ps, size_t j) {
+	ssize_t len;
+
+	if (pt->extra & PROC_EXTRA_CTX) {
+		ps->nvcsw[j] = ps->nivcsw[j] = 0;
+		if ((len = proc_track_load(pt, e->fd_status, e->pid, "status")) > 0)
+			proc_extra_parse_status(pt->buf, len, ps, j);
+	}
+	if (pt->extra & PROC_EXTRA_IO) {
+		ps->read_bytes[j] = ps->write_bytes[j] = 0;
+		if ((len = proc_track_load(pt, e->fd_io, e->pid, "io")) > 0)
+			proc_extra_parse_io(pt->buf, len, ps, j);
+	}
+}
+
+// Vul <ps> met een nieuwe meting van alle gevolgde processen die nog bestaan.  Geeft -1 terug
+// als er een proces niet gelezen kon worden omdat er geen fd vrij was (ook bij een eerdere
+// proc_track_probe()); dan is <ps> onvolledig en moet er een volledige enumeratie gedaan worden.
+// Een proces stilletjes overslaan zou het voor -p als gestopt (en daarna als nieuw) laten tellen.
+int proc_track_sample(proc_track_t *pt, PROC_SAMPLES *ps) {
+	proc_track_ent_t *e;
+	ssize_t len;
+	size_t j;
+
+	proc_samples_reset(ps);
+	for (size_t i=0; i<pt->cnt; i++) {
+		e = &pt->ent[i];
+		if (!e->alive)
+			continue;
+
+		if ((len = proc_track_load(pt, e->fd, e->pid, "stat")) == -1 && pt->fd_short)
+			return -1;
+
+		j = proc_samples_add(ps);
+		if (len <= 0 || proc_track_parse(pt, pt->buf, len, ps, j) == -1 || ps->start[j] != e->start) {
+			// Het proces is gestopt (ESRCH), of het PID-nummer is al hergebruikt.  Het
+			// proces komt niet meer terug; een nieuw proces vindt de volgende enumeratie.
+			ps->cnt--;
+			proc_track_drop(pt, i);
+			continue;
+		}
+		ps->pid[j]  = e->pid;
+		ps->tgid[j] = e->tgid;
+		ps->euid[j] = e->euid;
+		if (pt->extra)
+			proc_track_extra(pt, e, ps, j);
+	}
+	return pt->fd_short ? -1 : 0;
+}
+
+// Zoek een gevolgd proces op (ook een gestopt proces).  Geeft de index in pt->ent terug,
+// of -1 wanneer het PID niet gevolgd wordt.
+long proc_track_find(proc_track_t *pt, int pid) {
+	long lo = 0, hi = (long) pt->cnt - 1, mid;
+
+	while (lo <= hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pt->ent[mid].pid == pid)
+			return mid;
+		if (pt->ent[mid].pid < pid)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -1;
+}
+
+// Lees de effectieve uid (het tweede veld van "Uid:") uit /proc/PID/status, net als libproc2.
+// De eigenaar van /proc/PID is dat niet altijd: een proces dat met setuid() zijn rechten
+// heeft opgegeven (de workers van nginx, varnish, sshd) is niet meer dumpable, en dan is
+// root de eigenaar.  Met -x ctx is status al open (<fd>); anders wordt de file geopend.
+static int proc_track_euid(proc_track_t *pt, int fd, int pid, unsigned int *euid) {
+	char *p;
+
+	if (proc_track_load(pt, fd, pid, "status") == -1)
+		return -1;
+	if ((p = strstr(pt->buf, "\nUid:")) == NULL)
+		return -1;
+	strtoul(p + 5, &p, 10);                 // real uid
+	*euid = strtoul(p, NULL, 10);
+	return 0;
+}
+
+// Lees een proces in dat nog niet gevolgd wordt (na een event, zie proc-events.h): vult <e>
+// en laat <cmd> naar de naam van het proces wijzen, zodat de aanroeper kan beslissen of het
+// gevolgd moet worden.  De files van <e> blijven open; die moeten óf via proc_track_insert()
+// aan de set toegevoegd, óf met proc_track_close() gesloten worden.  Geeft -1 terug als het
+// proces alweer gestopt is.
+int proc_track_probe(proc_track_t *pt, int pid, proc_track_ent_t *e, char **cmd) {
+	unsigned int euid;
+	ssize_t len;
+
+	if (pt->probe == NULL)
+		pt->probe = proc_samples_create(1);
+	e->pid = pid;
+	proc_track_open_all(pt, e);
+	proc_samples_reset(pt->probe);
+	proc_samples_add(pt->probe);
+	if ((len = proc_track_load(pt, e->fd, pid, "stat")) == -1 ||
+	    proc_track_parse(pt, pt->buf, len, pt->probe, 0) == -1 ||
+	    proc_track_euid(pt, e->fd_status, pid, &euid) == -1) {
+		proc_track_close(pt, e);
+		return -1;
+	}
+	e->ppid  = pt->probe->ppid[0];
+	e->tgid  = pid;
+	e->euid  = euid;
+	e->start = pt->probe->start[0];
+	e->alive = 1;
+	*cmd = pt->probe->cmd[0];
+	return 0;
+}
+
+// Voeg een proces toe aan de set (op volgorde van PID).  Een gestopt proces met hetzelfde
+// PID wordt vervangen.
+void proc_track_insert(proc_track_t *pt, proc_track_ent_t *e) {
+	long lo = 0, hi = (long) pt->cnt;
+	proc_track_ent_t *ent;
+	long mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pt->ent[mid].pid < e->pid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < (long) pt->cnt && pt->ent[lo].pid == e->pid) {
+		proc_track_close(pt, &pt->ent[lo]);
+	} else {
+		if (pt->cnt == pt->cap) {
+			if ((ent = realloc(pt->ent, (pt->cap ? pt->cap * 2 : 16) * sizeof(proc_track_ent_t))) == NULL) {
+				printf("ERROR - realloc(%ld) failed, %d - %s\n", (pt->cap ? pt->cap * 2 : 16) * sizeof(proc_track_ent_t), errno, strerror(errno));
+				exit(EXIT_FAILURE);
+			}
+			pt->ent = ent;
+			pt->cap = pt->cap ? pt->cap * 2 : 16;
+		}
+		memmove(&pt->ent[lo + 1], &pt->ent[lo], (pt->cnt - lo) * sizeof(proc_track_ent_t));
+		pt->cnt++;
+	}
+	pt->ent[lo] = *e;
+	pt->added++;
+}
+
+// Volg een proces niet langer (gestopt, of het voldoet na een exec niet meer aan -c/-u).
+void proc_track_drop(proc_track_t *pt, long i) {
+	proc_track_ent_t *e = &pt->ent[i];
+
+	proc_track_close(pt, e);
+	e->alive = 0;
+	pt->gone++;
+}
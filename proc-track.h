@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define PROC_TRACK_BUF_SIZE 4096       // groot genoeg voor /proc/PID/status (ongeveer 1500 bytes)
+#define PROC_TRACK_FD_RESERVE 256      // fd's die niet door de gevolgde processen gebruikt mogen worden
+#define PROC_TRACK_FD_MAX 1048576      // bovengrens van het budget bij een onbeperkte RLIMIT_NOFILE
+
+// Goedkope sample-modus (optie -D): tussen twee volledige enumeraties via libproc2
+// worden alleen de processen bijgewerkt die bij de laatste enumeratie gevonden zijn.
+// Per proces blijft /proc/PID/stat open, zodat een meting één pread() kost en er geen
+// paden meer opgezocht hoeven te worden.  Een open stat-file blijft bij het oorspronkelijke
+// proces horen: als dat stopt geeft pread() ESRCH, ook als het PID-nummer hergebruikt wordt.
+// Het aantal open gehouden files is begrensd op RLIMIT_NOFILE min PROC_TRACK_FD_RESERVE; de
+// files van de processen daarboven worden per meting geopend en weer gesloten.
+// De processen staan gesorteerd op PID, zodat nieuwe processen (optie -e, zie proc-events.h)
+// tussen twee enumeraties opgezocht en ingevoegd kunnen worden.  Met -x ctx en/of io worden
+// ook /proc/PID/status en /proc/PID/io in dezelfde doorloop gelezen.  Die vallen onder hetzelfde
+// budget, maar pas nadat alle stat-files geopend zijn; daarboven kosten ze een open per meting.
+struct proc_track_ent {
+	int pid;
+	int fd;                            // open /proc/PID/stat, of -1 (buiten het budget)
+	int fd_status;                     // open /proc/PID/status (-x ctx), of -1
+	int fd_io;                         // open /proc/PID/io (-x io), of -1
+	int ppid;
+	int tgid;
+	unsigned int euid;
+	unsigned long long start;          // starttijd in ticks sinds boot (herkenning van hergebruikte PID's)
+	unsigned char alive;               // 0 zodra het proces gestopt is
+};
+
+struct proc_track {
+	struct proc_track_ent *ent;
+	size_t cnt;
+	size_t cap;
+	int proc_fd;                       // open directory /proc/ (voor openat())
+	long page_kib;                     // paginagrootte in KiB (rss in /proc/PID/stat is in pagina's)
+	unsigned int extra;                // PROC_EXTRA_CTX en/of PROC_EXTRA_IO: ook status en/of io lezen
+	long fd_budget;                    // maximum aantal open gehouden files (RLIMIT_NOFILE min de reserve)
+	long fd_kept;                      // aantal open gehouden files
+	int fd_short;                      // sinds de laatste enumeratie was er geen fd vrij (EMFILE/ENFILE)
+	unsigned long fd_fail;             // aantal keren dat er geen fd vrij was, sinds de start
+	unsigned long gone;                // aantal gestopte processen sinds de laatste enumeratie
+	unsigned long added;               // aantal via proc_track_insert() toegevoegde processen sinds de start
+	PROC_SAMPLES *probe;               // hulpbuffer voor proc_track_probe()
+	char buf[PROC_TRACK_BUF_SIZE];     // leesbuffer voor /proc/PID/stat, status en io
+};
+
+typedef struct proc_track_ent proc_track_ent_t;
+typedef struct proc_track     proc_track_t;
+
+proc_track_t * proc_track_create(unsigned int extra);
+void proc_track_destroy(proc_track_t *pt);
+void proc_track_rebuild(proc_track_t *pt, PROC_SAMPLES *ps);
+int  proc_track_sample(proc_track_t *pt, PROC_SAMPLES *ps);
+long proc_track_find(proc_track_t *pt, int pid);
+int  proc_track_probe(proc_track_t *pt, int pid, proc_track_ent_t *e, char **cmd);
+void proc_track_insert(proc_track_t *pt, proc_track_ent_t *e);
+void proc_track_drop(proc_track_t *pt, long i);
+void proc_track_close(proc_track_t *pt, proc_track_ent_t *e);
@@ -35,7 +35,11 @@
                                     PIDS_MEM_VIRT,
                                     PIDS_MEM_RES,
                                     PIDS_TICS_USER,
-                                    PIDS_TICS_SYSTEM};
+                                    PIDS_TICS_SYSTEM,
+                                    PIDS_TICS_BEGAN,
+                                    PIDS_FLT_MIN,          // de items van -x worden PIDS_noop als de klasse niet gevraagd is
+                                    PIDS_FLT_MAJ,
+                                    PIDS_NLWP};            // io niet: reap() zou /proc/PID/io van álle processen lezen
      enum rel_items {pids_cmd,
                      pids_euid,
                      pids_euser,
@@ -45,7 +49,12 @@
                      pids_vsz,
                      pids_rss,
                      pids_utime,
-                     pids_stime};
+                     pids_stime,
+                     pids_start,
+                     pids_minflt,
+                     pids_majflt,
+                     pids_nlwp};
      int number_of_items = sizeof(pids_items)/sizeof(pids_items[0]);
      struct pids_info *pids_info_data = NULL;
      struct pids_stack *pids_stack_data = NULL;
+     struct pids_fetch *pids_fetch_data = NULL;
@@ -0,0 +1,457 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE    // voor accept4()
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "ring-out.h"
+#include "prom-http.h"
+
+#define PROM_HDR_MAX 160               // ruimte vóór de body voor de HTTP-header
+
+#define PROM_UNIT_COUNT 0
+#define PROM_UNIT_KIB   1              // KiB, geëxporteerd in bytes
+#define PROM_UNIT_TICKS 2              // clock ticks, geëxporteerd in seconden
+
+// Eén tijdreeks per commando.  Opeenvolgende regels met dezelfde naam vormen één metric
+// (met een extra label), en krijgen samen één HELP- en TYPE-regel.
+static const struct prom_metric {
+	const char  *name;
+	const char  *help;
+	const char  *label;                // extra label naast command, of NULL
+	const char  *label_val;
+	size_t       off;                  // veld in ring_cmd_rec_t
+	int          unit;
+	unsigned int flag;                 // RING_FLAG_*: alleen exporteren als de optie actief is
+} prom_metrics[] = {
+	{ "cmd_metrics_processes", "Number of processes running the command.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, process_cnt), PROM_UNIT_COUNT, 0 },
+	{ "cmd_metrics_vsz_bytes", "Virtual memory size of the processes.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, vsz), PROM_UNIT_KIB, 0 },
+	{ "cmd_metrics_rss_bytes", "Resident set size of the processes.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, rss), PROM_UNIT_KIB, 0 },
+	{ "cmd_metrics_cpu_user_seconds", "User CPU time used by the processes that are running now.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, utime), PROM_UNIT_TICKS, 0 },
+	{ "cmd_metrics_cpu_system_seconds", "System CPU time used by the processes that are running now.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, stime), PROM_UNIT_TICKS, 0 },
+	{ "cmd_metrics_interval_cpu_user_seconds", "User CPU time used during the last interval.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, churn_utime), PROM_UNIT_TICKS, RING_FLAG_CHURN },
+	{ "cmd_metrics_interval_cpu_system_seconds", "System CPU time used during the last interval.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, churn_stime), PROM_UNIT_TICKS, RING_FLAG_CHURN },
+	{ "cmd_metrics_interval_spawned_processes", "Processes started during the last interval.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, churn_spawned), PROM_UNIT_COUNT, RING_FLAG_CHURN },
+	{ "cmd_metrics_interval_exited_processes", "Processes stopped during the last interval.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, churn_exited), PROM_UNIT_COUNT, RING_FLAG_CHURN },
+	{ "cmd_metrics_interval_rss_released_bytes", "RSS of the processes stopped during the last interval.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, churn_rss_released), PROM_UNIT_KIB, RING_FLAG_CHURN },
+	{ "cmd_metrics_sockets", "Number of sockets owned by the processes.", NULL, NULL,
+	  offsetof(ring_cmd_rec_t, sock_total), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_state", "Sockets per TCP state (other: all other sockets).", "state", "established",
+	  offsetof(ring_cmd_rec_t, sock_established), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_state", NULL, "state", "close_wait",
+	  offsetof(ring_cmd_rec_t, sock_close_wait), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_state", NULL, "state", "listen",
+	  offsetof(ring_cmd_rec_t, sock_listener), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_state", NULL, "state", "other",
+	  offsetof(ring_cmd_rec_t, sock_rest), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_family", "Sockets per address family and protocol.", "family", "tcp",
+	  offsetof(ring_cmd_rec_t, sock_tcp), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_family", NULL, "family", "tcp6",
+	  offsetof(ring_cmd_rec_t, sock_tcp6), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_family", NULL, "family", "udp",
+	  offsetof(ring_cmd_rec_t, sock_udp), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_family", NULL, "family", "udp6",
+	  offsetof(ring_cmd_rec_t, sock_udp6), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+	{ "cmd_metrics_sockets_by_family", NULL, "family", "unix",
+	  offsetof(ring_cmd_rec_t, sock_unix), PROM_UNIT_COUNT, RING_FLAG_SOCKETS },
+};
+
+static const char prom_404[] = "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n"
+                               "Connection: close\r\n\r\nnot found\n";
+static const char prom_405[] = "HTTP/1.1 405 Method Not Allowed\r\nContent-Type: text/plain\r\nContent-Length: 19\r\n"
+                               "Allow: GET\r\nConnection: close\r\n\r\nmethod not allowed\n";
+static const char prom_400[] = "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\nContent-Length: 12\r\n"
+                               "Connection: close\r\n\r\nbad request\n";
+
+static int prom_listen_unix(const char *path) {
+	struct sockaddr_un sun;
+	struct stat st;
+	int fd;
+
+	if (strlen(path) >= sizeof(sun.sun_path)) {
+		printf("ERROR - socket path %s is too long\n", path);
+		exit(EXIT_FAILURE);
+	}
+	// Een socket van een vorige run blijft achter na een crash; een ander soort bestand niet weggooien.
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	strcpy(sun.sun_path, path);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1 ||
+	    bind(fd, (struct sockaddr *)&sun, sizeof(sun)) == -1) {
+		printf("ERROR - failed to bind to %s, %d - %s\n", path, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return fd;
+}
+
+// addr is <port>, <host>:<port> of [<ipv6-adres>]:<port>.  Zonder host alleen op loopback.
+static int prom_listen_tcp(const char *addr) {
+	struct addrinfo hints, *res;
+	char host[256] = "127.0.0.1";
+	const char *port = addr;
+	const char *colon = strrchr(addr, ':');
+	size_t n;
+	int fd, rc, one = 1;
+
+	if (colon) {
+		n = colon - addr;
+		if (n >= 2 && addr[0] == '[' && addr[n - 1] == ']') {
+			addr++;
+			n -= 2;
+		}
+		if (n >= sizeof(host)) {
+			printf("ERROR - host name in %s is too long\n", addr);
+			exit(EXIT_FAILURE);
+		}
+		memcpy(host, addr, n);
+		host[n] = '\0';
+		port = colon + 1;
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags    = AI_PASSIVE;
+	if ((rc = getaddrinfo(host, port, &hints, &res)) != 0) {
+		printf("ERROR - invalid listen address %s:%s - %s\n", host, port, gai_strerror(rc));
+		exit(EXIT_FAILURE);
+	}
+	if ((fd = socket(res->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1 ||
+	    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == -1 ||
+	    bind(fd, res->ai_addr, res->ai_addrlen) == -1) {
+		printf("ERROR - failed to bind to %s:%s, %d - %s\n", host, port, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	freeaddrinfo(res);
+	return fd;
+}
+
+static void prom_epoll_ctl(prom_t *p, int op, int fd, unsigned int events, void *ptr) {
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events   = events;
+	ev.data.ptr = ptr;
+	if (epoll_ctl(p->epoll_fd, op, fd, &ev) == -1) {
+		printf("ERROR - epoll_ctl failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+prom_t * prom_create(const char *addr) {
+	prom_t *p;
+	int i;
+
+	if ((p = calloc(1, sizeof(prom_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(prom_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	for (i=0; i<PROM_MAX_CLIENTS; i++)
+		p->client[i].fd = -1;
+
+	if (addr[0] == '/') {
+		p->listen_fd = prom_listen_unix(addr);
+		p->unix_path = strdup(addr);
+	} else {
+		p->listen_fd = prom_listen_tcp(addr);
+	}
+	if (listen(p->listen_fd, 64) == -1) {
+		printf("ERROR - listen on %s failed, %d - %s\n", addr, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if ((p->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		printf("ERROR - epoll_create1 failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	prom_epoll_ctl(p, EPOLL_CTL_ADD, p->listen_fd, EPOLLIN, NULL);
+	return p;
+}
+
+static void prom_snap_put(prom_snap_t *s) {
+	if (s && --s->refcnt == 0) {
+		free(s->buf);
+		free(s);
+	}
+}
+
+// close() haalt de fd ook uit de epoll-set.
+static void prom_client_close(prom_t *p, prom_client_t *c) {
+	close(c->fd);
+	c->fd = -1;
+	prom_snap_put(c->snap);
+	c->snap = NULL;
+	c->resp = NULL;
+	// Er is weer plaats: luister weer naar nieuwe verbindingen.
+	if (p->busy-- == PROM_MAX_CLIENTS)
+		prom_epoll_ctl(p, EPOLL_CTL_MOD, p->listen_fd, EPOLLIN, NULL);
+}
+
+void prom_destroy(prom_t *p) {
+	int i;
+
+	for (i=0; i<PROM_MAX_CLIENTS; i++) {
+		if (p->client[i].fd != -1)
+			prom_client_close(p, &p->client[i]);
+	}
+	close(p->listen_fd);
+	close(p->epoll_fd);
+	if (p->unix_path) {
+		unlink(p->unix_path);
+		free(p->unix_path);
+	}
+	prom_snap_put(p->snap);
+	free(p);
+}
+
+static void prom_snap_printf(prom_snap_t *s, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void prom_snap_printf(prom_snap_t *s, const char *fmt, ...) {
+	va_list ap;
+	int n;
+
+	for (;;) {
+		va_start(ap, fmt);
+		n = vsnprintf(s->buf + s->len, s->cap - s->len, fmt, ap);
+		va_end(ap);
+		if (n >= 0 && (size_t)n < s->cap - s->len)
+			break;
+		s->cap *= 2;
+		if ((s->buf = realloc(s->buf, s->cap)) == NULL) {
+			printf("ERROR - realloc(%ld) failed, %d - %s\n", s->cap, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+	s->len += n;
+}
+
+// Label-waarden: \, " en newline moeten ge-escaped worden.
+static void prom_snap_label(prom_snap_t *s, const char *val) {
+	for (; *val; val++) {
+		if (*val == '\\' || *val == '"')
+			prom_snap_printf(s, "\\%c", *val);
+		else if (*val == '\n')
+			prom_snap_printf(s, "\\n");
+		else
+			prom_snap_printf(s, "%c", *val);
+	}
+}
+
+void prom_render(prom_t *p, int cmd_cnt, char **names, const ring_cmd_rec_t *rec,
+                 long ticks_per_sec, unsigned int flags, int64_t time_ns) {
+	const struct prom_metric *m;
+	const char *prev = "";
+	prom_snap_t *s = p->snap;
+	char hdr[PROM_HDR_MAX];
+	size_t body_len;
+	int64_t v;
+	int i, h;
+
+	// Hergebruik de buffer, tenzij een client de vorige response nog aan het versturen is.
+	if (s == NULL || s->refcnt > 1) {
+		prom_snap_put(s);
+		if ((s = calloc(1, sizeof(prom_snap_t))) == NULL ||
+		    (s->buf = malloc(PROM_INITIAL_SIZE)) == NULL) {
+			printf("ERROR - malloc(%d) failed, %d - %s\n", PROM_INITIAL_SIZE, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		s->cap    = PROM_INITIAL_SIZE;
+		s->refcnt = 1;
+		p->snap   = s;
+	}
+
+	// De body komt achter een gat van PROM_HDR_MAX bytes; de header wordt er daarna vóór gezet.
+	s->len = PROM_HDR_MAX;
+	for (m=prom_metrics; m<prom_metrics + sizeof(prom_metrics) / sizeof(prom_metrics[0]); m++) {
+		if (m->flag && !(flags & m->flag))
+			continue;
+		if (strcmp(m->name, prev) != 0) {
+			prom_snap_printf(s, "# HELP %s %s\n# TYPE %s gauge\n", m->name, m->help, m->name);
+			prev = m->name;
+		}
+		for (i=0; i<cmd_cnt; i++) {
+			v = *(const int64_t *)((const char *)&rec[i] + m->off);
+			prom_snap_printf(s, "%s{command=\"", m->name);
+			prom_snap_label(s, names[i]);
+			if (m->label)
+				prom_snap_printf(s, "\",%s=\"%s", m->label, m->label_val);
+			if (m->unit == PROM_UNIT_TICKS)
+				prom_snap_printf(s, "\"} %.2f\n", (double)v / ticks_per_sec);
+			else
+				prom_snap_printf(s, "\"} %lld\n", (long long)(m->unit == PROM_UNIT_KIB ? v * 1024 : v));
+		}
+	}
+	prom_snap_printf(s, "# HELP cmd_metrics_last_sample_timestamp_seconds Time of the last sample.\n"
+	                    "# TYPE cmd_metrics_last_sample_timestamp_seconds gauge\n"
+	                    "cmd_metrics_last_sample_timestamp_seconds %lld.%03lld\n",
+	                 (long long)(time_ns / 1000000000), (long long)(time_ns % 1000000000 / 1000000));
+
+	body_len = s->len - PROM_HDR_MAX;
+	h = snprintf(hdr, sizeof(hdr), "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+	                               "Content-Length: %zu\r\nConnection: close\r\n\r\n", body_len);
+	memcpy(s->buf + PROM_HDR_MAX - h, hdr, h);
+	s->off = PROM_HDR_MAX - h;
+}
+
+// Verstuur zoveel mogelijk van de response; sluit de verbinding als alles weg is.
+// Past niet alles in de socket-buffer, dan wacht de client verder op EPOLLOUT.
+static void prom_client_send(prom_t *p, prom_client_t *c) {
+	const char *buf = c->snap ? c->snap->buf + c->snap->off : c->resp;
+	size_t len = c->snap ? c->snap->len - c->snap->off : c->resp_len;
+	ssize_t n;
+
+	while (c->sent < len) {
+		if ((n = send(c->fd, buf + c->sent, len - c->sent, MSG_NOSIGNAL)) == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				prom_epoll_ctl(p, EPOLL_CTL_MOD, c->fd, EPOLLOUT, c);
+			else
+				prom_client_close(p, c);
+			return;
+		}
+		c->sent += n;
+	}
+	prom_client_close(p, c);
+}
+
+static void prom_client_respond(prom_t *p, prom_client_t *c, const char *resp, size_t len) {
+	c->resp     = resp;
+	c->resp_len = len;
+	c->sent     = 0;
+	prom_client_send(p, c);
+}
+
+// Lees de request.  Alleen de eerste regel telt: GET /metrics (of GET /) krijgt de laatste render.
+static void prom_client_read(prom_t *p, prom_client_t *c) {
+	ssize_t n;
+
+	if ((n = recv(c->fd, c->req + c->req_len, PROM_REQ_LEN - 1 - c->req_len, 0)) <= 0) {
+		if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+			prom_client_close(p, c);
+		return;
+	}
+	c->req_len += n;
+	c->req[c->req_len] = '\0';
+	if (strstr(c->req, "\r\n\r\n") == NULL && strstr(c->req, "\n\n") == NULL) {
+		if (c->req_len == PROM_REQ_LEN - 1)
+			prom_client_respond(p, c, prom_400, sizeof(prom_400) - 1);
+		return;
+	}
+
+	if (strncmp(c->req, "GET ", 4) != 0) {
+		prom_client_respond(p, c, prom_405, sizeof(prom_405) - 1);
+	} else if (strncmp(c->req + 4, "/metrics ", 9) == 0 || strncmp(c->req + 4, "/ ", 2) == 0) {
+		c->snap = p->snap;
+		c->snap->refcnt++;
+		c->sent = 0;
+		p->scrapes++;
+		prom_client_send(p, c);
+	} else {
+		prom_client_respond(p, c, prom_404, sizeof(prom_404) - 1);
+	}
+}
+
+static void prom_accept(prom_t *p, time_t now) {
+	int i, fd;
+
+	for (i=0; i<PROM_MAX_CLIENTS; i++) {
+		if (p->client[i].fd != -1)
+			continue;
+		if ((fd = accept4(p->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) == -1)
+			return;
+		memset(&p->client[i], 0, offsetof(prom_client_t, req));
+		p->client[i].fd    = fd;
+		p->client[i].since = now;
+		prom_epoll_ctl(p, EPOLL_CTL_ADD, fd, EPOLLIN, &p->client[i]);
+		// Alle plaatsen bezet: nieuwe verbindingen wachten in de backlog.
+		if (++p->busy == PROM_MAX_CLIENTS)
+			prom_epoll_ctl(p, EPOLL_CTL_MOD, p->listen_fd, 0, NULL);
+	}
+}
+
+// De epoll-set van het endpoint, om in de wacht-loop van het programma op te nemen.
+int prom_fd(prom_t *p) {
+	return p->epoll_fd;
+}
+
+// Hoe lang er maximaal gewacht mag worden voordat prom_serve() weer aangeroepen moet
+// worden (voor het afsluiten van trage clients); -1 als er geen clients zijn.
+int prom_timeout_ms(prom_t *p) {
+	return p->busy > 0 ? 1000 : -1;
+}
+
+// Handel af wat er klaarstaat, zonder te wachten, en sluit clients die te lang bezig zijn.
+void prom_serve(prom_t *p) {
+	struct epoll_event ev[PROM_MAX_CLIENTS + 1];
+	prom_client_t *c;
+	time_t now = time(NULL);
+	int i, n;
+
+	for (i=0; i<PROM_MAX_CLIENTS; i++) {
+		if (p->client[i].fd != -1 && now - p->client[i].since > PROM_CLIENT_TIMEOUT)
+			prom_client_close(p, &p->client[i]);
+	}
+
+	if ((n = epoll_wait(p->epoll_fd, ev, PROM_MAX_CLIENTS + 1, 0)) <= 0)
+		return;
+	for (i=0; i<n; i++) {
+		c = ev[i].data.ptr;
+		if (c == NULL)
+			prom_accept(p, now);
+		else if (c->fd == -1)
+			continue;                // in deze ronde al gesloten
+		else if (c->snap || c->resp)
+			prom_client_send(p, c);
+		else
+			prom_client_read(p, c);
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Pull-endpoint in het Prometheus text-formaat (optie -P).
+//
+// De response wordt één keer per interval opgebouwd (prom_render()) en daarna aan elke
+// scraper uit dezelfde buffer geserveerd; een scrape kost dus alleen een accept() en een
+// send().  De buffer heeft een referentieteller: een client die nog bezig is met een oude
+// response houdt die vast, de volgende render gebruikt dan een nieuwe buffer.
+//
+// De listener en de clients zitten in een eigen epoll-set (prom_fd()), die in de
+// wacht-loop van het programma wordt opgenomen (zie tick-loop.h).  Is die set gereed,
+// dan handelt prom_serve() zonder te wachten af wat er klaarstaat.
+
+#define PROM_MAX_CLIENTS     32
+#define PROM_REQ_LEN         1024          // een GET-request van een scraper is veel korter
+#define PROM_CLIENT_TIMEOUT  5             // seconden; daarna wordt een trage client afgesloten
+#define PROM_INITIAL_SIZE    16384
+
+struct prom_snap {
+	int refcnt;
+	size_t off;                        // begin van de response (HTTP-header) in buf
+	size_t len;                        // einde van de body
+	size_t cap;
+	char *buf;
+};
+
+struct prom_client {
+	int fd;                            // -1: vrij
+	time_t since;                      // tijdstip van accept()
+	size_t req_len;
+	size_t sent;
+	struct prom_snap *snap;            // de response, zodra de request binnen is
+	const char *resp;                  // response zonder snapshot (404 e.d.)
+	size_t resp_len;
+	char req[PROM_REQ_LEN];
+};
+
+struct prom {
+	int listen_fd;
+	int epoll_fd;                      // listener (data.ptr NULL) en clients (data.ptr de client)
+	int busy;                          // aantal bezette client-plaatsen
+	char *unix_path;                   // te verwijderen bij prom_destroy() (alleen AF_UNIX)
+	struct prom_snap *snap;            // de laatste render
+	unsigned long scrapes;
+	struct prom_client client[PROM_MAX_CLIENTS];
+};
+
+typedef struct prom_snap   prom_snap_t;
+typedef struct prom_client prom_client_t;
+typedef struct prom        prom_t;
+
+prom_t * prom_create(const char *addr);
+void prom_destroy(prom_t *p);
+void prom_render(prom_t *p, int cmd_cnt, char **names, const ring_cmd_rec_t *rec,
+                 long ticks_per_sec, unsigned int flags, int64_t time_ns);
+int  prom_fd(prom_t *p);
+int  prom_timeout_ms(prom_t *p);
+void prom_serve(prom_t *p);
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark voor de binaire ring-buffer output (optie -m).
+ *
+ * Gebruik: ./ring-bench [aantal records] [aantal commando's] [aantal slots]
+ *
+ * Een schrijver vult zo snel mogelijk records in een ring in /tmp, terwijl een lezer-thread
+ * tegelijkertijd meeleest.  De lezer controleert elk record (alle velden zijn afgeleid van
+ * het recordnummer), zodat een gescheurd record opvalt.  Ter vergelijking wordt dezelfde
+ * data ook als tekst geformatteerd zoals list_deltas() dat doet, naar /dev/null.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ring-out.h"
+
+#define BENCH_RECORDS 2000000
+#define BENCH_CMDS    8
+#define BENCH_SLOTS   RING_SLOTS_DEFAULT
+
+static const char *ring_path = "/tmp/ring-bench.ring";
+static volatile int writer_done = 0;
+
+typedef struct reader_result {
+	unsigned long read;
+	unsigned long overruns;
+	unsigned long torn;
+} reader_result_t;
+
+static double elapsed(struct timespec *t0, struct timespec *t1) {
+	return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static void fill(ring_cmd_rec_t *c, uint32_t cmd_cnt, uint64_t n) {
+	for (uint32_t i=0; i<cmd_cnt; i++) {
+		int64_t *f = (int64_t *) &c[i];
+		for (size_t k=0; k<sizeof(ring_cmd_rec_t)/sizeof(int64_t); k++)
+			f[k] = n * 31 + i * 7 + k;
+	}
+}
+
+static int check(ring_cmd_rec_t *c, uint32_t cmd_cnt, uint64_t n) {
+	for (uint32_t i=0; i<cmd_cnt; i++) {
+		int64_t *f = (int64_t *) &c[i];
+		for (size_t k=0; k<sizeof(ring_cmd_rec_t)/sizeof(int64_t); k++)
+			if (f[k] != (int64_t) (n * 31 + i * 7 + k))
+				return -1;
+	}
+	return 0;
+}
+
+static void * reader(void *arg) {
+	reader_result_t *res = arg;
+	ring_t *r = ring_in_open(ring_path);
+	ring_rec_t *rec;
+	uint64_t n = 0, head;
+
+	if (!r || (rec = malloc(r->hdr->rec_size)) == NULL) {
+		fprintf(stderr, "ERROR: reader cannot open %s: %d (%s)\n", ring_path, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	while (1) {
+		switch (ring_in_read(r, n, rec)) {
+		case RING_OK:
+			if (check(rec->cmd, r->hdr->cmd_cnt, n) == -1)
+				res->torn++;
+			res->read++;
+			n++;
+			break;
+		case RING_OVERRUN:
+			res->overruns++;
+			head = ring_in_write_seq(r);
+			n = head - r->hdr->slot_cnt + 1;
+			break;
+		case RING_NOT_YET:
+			if (writer_done && n >= ring_in_write_seq(r))
+				goto done;
+			break;
+		}
+	}
+done:
+	free(rec);
+	ring_close(r);
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	long records = argc > 1 ? atol(argv[1]) : BENCH_RECORDS;
+	int cmd_cnt  = argc > 2 ? atoi(argv[2]) : BENCH_CMDS;
+	int slots    = argc > 3 ? atoi(argv[3]) : BENCH_SLOTS;
+	char *names[cmd_cnt > 0 ? cmd_cnt : 1];
+	char name_buf[cmd_cnt > 0 ? cmd_cnt : 1][RING_CMD_LEN];
+	reader_result_t res = {0, 0, 0};
+	struct timespec t0, t1;
+	pthread_t tid;
+	ring_t *r;
+	FILE *devnull;
+
+	if (records <= 0 || cmd_cnt <= 0 || slots <= 0) {
+		fprintf(stderr, "syntax: $ ring-bench [records] [commands] [slots]\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i=0; i<cmd_cnt; i++) {
+		snprintf(name_buf[i], RING_CMD_LEN, "cmd%d", i);
+		names[i] = name_buf[i];
+	}
+
+	// Binaire ring met een meelezende lezer
+	r = ring_out_create(ring_path, slots, cmd_cnt, names, 100, RING_FLAG_SOCKETS | RING_FLAG_CHURN);
+	pthread_create(&tid, NULL, reader, &res);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (long n=0; n<records; n++) {
+		fill(ring_out_begin(r), cmd_cnt, n);
+		ring_out_commit(r, n);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	writer_done = 1;
+	pthread_join(tid, NULL);
+	printf("ring:  %ld records x %d commands, %d slots of %u bytes\n", records, cmd_cnt, slots, r->hdr->rec_size);
+	printf("ring:  write %8.2f Mrecords/s   reader: %lu read, %lu overruns, %lu torn\n",
+	       records / elapsed(&t0, &t1) / 1e6, res.read, res.overruns, res.torn);
+	ring_close(r);
+	unlink(ring_path);
+
+	// Dezelfde data als tekst, zoals list_deltas() die afdrukt
+	if ((devnull = fopen("/dev/null", "w")) == NULL) {
+		fprintf(stderr, "ERROR: fopen of /dev/null failed: %d (%s)\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	ring_cmd_rec_t c[cmd_cnt];
+	long text_records = records / 10 > 0 ? records / 10 : 1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (long n=0; n<text_records; n++) {
+		fill(c, cmd_cnt, n);
+		fprintf(devnull, "%14s", "20250101000000");
+		for (int i=0; i<cmd_cnt; i++) {
+			fprintf(devnull, "|%5d  %11ld  %9ld  %11ld  %9ld  %8.2f  %8.2f",
+			        (int) c[i].process_cnt, (long) c[i].vsz, (long) c[i].vsz, (long) c[i].rss, (long) c[i].rss,
+			        (float) c[i].utime / 100, (float) c[i].stime / 100);
+			fprintf(devnull, "  %8.2f  %8.2f %5ld %5ld %11ld",
+			        (float) c[i].churn_utime / 100, (float) c[i].churn_stime / 100,
+			        (long) c[i].churn_spawned, (long) c[i].churn_exited, (long) c[i].churn_rss_released);
+			fprintf(devnull, " %5ld %5ld %5ld %5ld %5ld %5ld %5ld %5ld %5ld %5ld %5ld",
+			        (long) c[i].sock_total, (long) c[i].sock_total, (long) c[i].sock_established,
+			        (long) c[i].sock_close_wait, (long) c[i].sock_listener, (long) c[i].sock_rest,
+			        (long) c[i].sock_tcp, (long) c[i].sock_tcp6, (long) c[i].sock_udp,
+			        (long) c[i].sock_udp6, (long) c[i].sock_unix);
+		}
+		fprintf(devnull, "\n");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fclose(devnull);
+	printf("text:  write %8.2f Mrecords/s   (printf, %ld records)\n", text_records / elapsed(&t0, &t1) / 1e6, text_records);
+	exit(EXIT_SUCCESS);
+}
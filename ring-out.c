@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ring-out.h"
+
+#define RING_REC(r, n) ((ring_rec_t *) ((char *) (r)->hdr + (r)->hdr->hdr_size + \
+                                        ((n) % (r)->hdr->slot_cnt) * (size_t) (r)->hdr->rec_size))
+
+static ring_t * ring_alloc(void) {
+	ring_t *r;
+
+	if ((r = calloc(1, sizeof(ring_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(ring_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return r;
+}
+
+// Maak het ring-bestand aan en map het in het geheugen.  Het bestand wordt onder een tijdelijke
+// naam opgebouwd en daarna met rename() op zijn plaats gezet: een lezer die een vorige ring nog
+// gemapt heeft houdt zo de oude inode (geen SIGBUS door een truncate) en kan aan de gewijzigde
+// inode zien dat de schrijver opnieuw gestart is.
+ring_t * ring_out_create(const char *path, uint32_t slot_cnt, uint32_t cmd_cnt, char **names,
+                         uint32_t ticks_per_sec, uint32_t flags) {
+	ring_t *r = ring_alloc();
+	size_t hdr_size, rec_size;
+	char tmp_path[PATH_MAX];
+
+	// Laat de records op een cache-line beginnen.
+	hdr_size = (sizeof(ring_hdr_t) + cmd_cnt * RING_CMD_LEN + 63) & ~(size_t) 63;
+	rec_size = (sizeof(ring_rec_t) + cmd_cnt * sizeof(ring_cmd_rec_t) + 63) & ~(size_t) 63;
+	r->map_size = hdr_size + slot_cnt * rec_size;
+
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d", path, (int) getpid()) >= (int) sizeof(tmp_path)) {
+		fprintf(stderr, "ERROR: ring file name %s is too long\n", path);
+		exit(EXIT_FAILURE);
+	}
+	if ((r->fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1) {
+		fprintf(stderr, "ERROR: open of %s failed: %d (%s)\n", tmp_path, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if (ftruncate(r->fd, r->map_size) == -1) {
+		fprintf(stderr, "ERROR: ftruncate of %s failed: %d (%s)\n", tmp_path, errno, strerror(errno));
+		unlink(tmp_path);
+		exit(EXIT_FAILURE);
+	}
+	if ((r->hdr = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, 0)) == MAP_FAILED) {
+		fprintf(stderr, "ERROR: mmap of %s failed: %d (%s)\n", tmp_path, errno, strerror(errno));
+		unlink(tmp_path);
+		exit(EXIT_FAILURE);
+	}
+
+	// ftruncate() heeft het bestand al met nullen gevuld, dus alle slots hebben seq 0 (leeg).
+	r->hdr->version       = RING_VERSION;
+	r->hdr->hdr_size      = hdr_size;
+	r->hdr->rec_size      = rec_size;
+	r->hdr->slot_cnt      = slot_cnt;
+	r->hdr->cmd_cnt       = cmd_cnt;
+	r->hdr->ticks_per_sec = ticks_per_sec;
+	r->hdr->flags         = flags;
+	r->hdr->write_seq     = 0;
+	for (uint32_t i=0; i<cmd_cnt; i++)
+		strncpy(r->hdr->cmd[i], names[i], RING_CMD_LEN - 1);
+	// De magic als laatste, zodat een lezer nooit een half geïnitialiseerde header ziet.
+	__atomic_store_n(&r->hdr->magic, RING_MAGIC, __ATOMIC_RELEASE);
+	if (rename(tmp_path, path) == -1) {
+		fprintf(stderr, "ERROR: rename of %s to %s failed: %d (%s)\n", tmp_path, path, errno, strerror(errno));
+		unlink(tmp_path);
+		exit(EXIT_FAILURE);
+	}
+	return r;
+}
+
+// Begin met het schrijven van het volgende record en geef de cmd-records ervan terug.
+// De aanroeper vult ze rechtstreeks in het gemapte geheugen en roept dan ring_out_commit() aan.
+ring_cmd_rec_t * ring_out_begin(ring_t *r) {
+	ring_rec_t *rec = RING_REC(r, r->seq);
+
+	__atomic_store_n(&rec->seq, 2 * r->seq + 1, __ATOMIC_RELAXED);   // oneven: wordt geschreven
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return rec->cmd;
+}
+
+void ring_out_commit(ring_t *r, int64_t time_ns) {
+	ring_rec_t *rec = RING_REC(r, r->seq);
+
+	rec->time_ns = time_ns;
+	__atomic_store_n(&rec->seq, 2 * r->seq + 2, __ATOMIC_RELEASE);   // even: record r->seq is compleet
+	r->seq++;
+	__atomic_store_n(&r->hdr->write_seq, r->seq, __ATOMIC_RELEASE);
+}
+
+void ring_close(ring_t *r) {
+	munmap(r->hdr, r->map_size);
+	close(r->fd);
+	free(r);
+}
+
+// Open een bestaand ring-bestand om te lezen.  Geeft NULL terug (met errno) bij een fout.
+ring_t * ring_in_open(const char *path) {
+	ring_t *r = ring_alloc();
+	struct stat st;
+
+	if ((r->fd = open(path, O_RDONLY | O_CLOEXEC)) == -1 || fstat(r->fd, &st) == -1)
+		goto fail;
+	if (st.st_size < (off_t) sizeof(ring_hdr_t)) {
+		errno = EINVAL;
+		goto fail;
+	}
+	r->map_size = st.st_size;
+	if ((r->hdr = mmap(NULL, r->map_size, PROT_READ, MAP_SHARED, r->fd, 0)) == MAP_FAILED)
+		goto fail;
+	if (__atomic_load_n(&r->hdr->magic, __ATOMIC_ACQUIRE) != RING_MAGIC || r->hdr->version != RING_VERSION ||
+	    r->hdr->hdr_size + (size_t) r->hdr->slot_cnt * r->hdr->rec_size > r->map_size) {
+		munmap(r->hdr, r->map_size);
+		errno = EINVAL;
+		goto fail;
+	}
+	return r;
+
+fail:
+	if (r->fd != -1)
+		close(r->fd);
+	free(r);
+	return NULL;
+}
+
+uint64_t ring_in_write_seq(ring_t *r) {
+	return __atomic_load_n(&r->hdr->write_seq, __ATOMIC_ACQUIRE);
+}
+
+// Kopieer record <n> naar <rec> (minimaal rec_size bytes).
+// Geeft RING_OK, RING_NOT_YET of RING_OVERRUN terug.
+int ring_in_read(ring_t *r, uint64_t n, ring_rec_t *rec) {
+	ring_rec_t *slot = RING_REC(r, n);
+	uint64_t s1, s2;
+
+	// Een oneven teller betekent dat de schrijver met dit slot bezig is: met record n
+	// (nog niet klaar) of met een nieuwer record (n is dan al verloren).
+	s1 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+	if (s1 < 2 * n + 2)
+		return RING_NOT_YET;
+	if (s1 > 2 * n + 2)
+		return RING_OVERRUN;
+	memcpy(rec, slot, r->hdr->rec_size);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	s2 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+	if (s1 != s2)
+		return RING_OVERRUN;    // tijdens het kopiëren is het slot overschreven
+	return RING_OK;
+}
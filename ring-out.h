@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+
+// Binaire ring-buffer output (optie -m).
+//
+// De samples worden als records met een vaste grootte in een memory-mapped bestand
+// geschreven, zodat lokale lezers (dashboards) ze kunnen volgen zonder de tekst-output
+// te parsen, en zonder de meet-loop ooit te laten wachten.  Het bestand bestaat uit:
+//
+//     ring_hdr_t                   header, gevolgd door cmd_cnt namen van RING_CMD_LEN bytes
+//     slot_cnt x ring_rec_t        records, elk rec_size bytes (inclusief cmd_cnt x ring_cmd_rec_t)
+//
+// Record n (vanaf 0) staat in slot n % slot_cnt.  Elk slot heeft een eigen seqlock-teller:
+// oneven tijdens het schrijven, 2n+2 wanneer record n compleet is.  Een lezer kopieert het
+// slot, controleert de teller vóór en na het kopiëren, en weet dan of het record heel is,
+// nog niet geschreven is, of inmiddels door de schrijver is ingehaald.
+// write_seq in de header is het aantal complete records.
+
+#define RING_MAGIC         0x474e5243      // "CRNG"
+#define RING_VERSION       1
+#define RING_CMD_LEN       (64+1)
+#define RING_SLOTS_DEFAULT 4096
+
+#define RING_FLAG_SOCKETS  0x1             // de socket-velden zijn gevuld (-s)
+#define RING_FLAG_CHURN    0x2             // de churn-velden zijn gevuld (-p)
+
+typedef struct ring_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t hdr_size;                 // offset van het eerste slot
+	uint32_t rec_size;                 // grootte van één slot
+	uint32_t slot_cnt;
+	uint32_t cmd_cnt;
+	uint32_t ticks_per_sec;            // eenheid van utime/stime
+	uint32_t flags;
+	uint64_t write_seq;                // aantal complete records
+	char     cmd[][RING_CMD_LEN];      // de namen van de commando's (-c)
+} ring_hdr_t;
+
+// De metingen van één commando in één interval.  vsz en rss in KiB, tijden in ticks.
+typedef struct ring_cmd_rec {
+	int64_t  process_cnt;
+	int64_t  vsz;
+	int64_t  rss;
+	int64_t  utime;
+	int64_t  stime;
+	int64_t  churn_utime;
+	int64_t  churn_stime;
+	int64_t  churn_spawned;
+	int64_t  churn_exited;
+	int64_t  churn_rss_released;
+	int64_t  sock_total;
+	int64_t  sock_established;
+	int64_t  sock_close_wait;
+	int64_t  sock_listener;
+	int64_t  sock_rest;
+	int64_t  sock_tcp;
+	int64_t  sock_tcp6;
+	int64_t  sock_udp;
+	int64_t  sock_udp6;
+	int64_t  sock_unix;
+} ring_cmd_rec_t;
+
+typedef struct ring_rec {
+	uint64_t seq;                      // seqlock-teller (zie boven)
+	int64_t  time_ns;                  // CLOCK_REALTIME van de meting
+	ring_cmd_rec_t cmd[];
+} ring_rec_t;
+
+// Schrijfkant (cmd-metrics) en leeskant (ring-read, ring-bench)
+typedef struct ring {
+	ring_hdr_t *hdr;
+	size_t      map_size;
+	int         fd;
+	uint64_t    seq;                   // volgende recordnummer (alleen schrijfkant)
+} ring_t;
+
+#define RING_OK          0
+#define RING_NOT_YET    -1                 // het record is (nog) niet geschreven
+#define RING_OVERRUN    -2                 // het record is al overschreven door een nieuwer record
+
+ring_t *         ring_out_create(const char *path, uint32_t slot_cnt, uint32_t cmd_cnt, char **names,
+                                 uint32_t ticks_per_sec, uint32_t flags);
+ring_cmd_rec_t * ring_out_begin(ring_t *r);
+void             ring_out_commit(ring_t *r, int64_t time_ns);
+void             ring_close(ring_t *r);
+ring_t *         ring_in_open(const char *path);
+uint64_t         ring_in_write_seq(ring_t *r);
+int              ring_in_read(ring_t *r, uint64_t n, ring_rec_t *rec);
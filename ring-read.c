@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Lezer voor de binaire ring-buffer output van cmd-metrics (optie -m).
+ *
+ * Gebruik: ./ring-read [-f] <ring-file>
+ *
+ * Drukt de records af die nog in de ring staan, één regel per commando per meting.
+ * Met -f blijft het programma de ring volgen (zoals tail -f), ook over een herstart van
+ * cmd-metrics heen: dan wordt het nieuwe bestand geopend.  De lezer kopieert alleen uit het
+ * gemapte bestand en houdt de schrijver dus nooit op.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ring-out.h"
+
+#define RING_READ_POLL_US 100000
+
+static void print_rec(ring_t *r, ring_rec_t *rec) {
+	ring_hdr_t *h = r->hdr;
+	char time_string[32];
+	time_t t = rec->time_ns / 1000000000;
+	struct tm *tm_info = localtime(&t);
+
+	strftime(time_string, sizeof(time_string), "%Y%m%d%H%M%S", tm_info);
+	for (uint32_t i=0; i<h->cmd_cnt; i++) {
+		ring_cmd_rec_t *c = &rec->cmd[i];
+
+		printf("%s %-16s %5ld %11ld %11ld %8.2f %8.2f", time_string, h->cmd[i],
+		       (long) c->process_cnt, (long) c->vsz, (long) c->rss,
+		       (double) c->utime / h->ticks_per_sec, (double) c->stime / h->ticks_per_sec);
+		if (h->flags & RING_FLAG_CHURN)
+			printf(" %8.2f %8.2f %5ld %5ld %11ld",
+			       (double) c->churn_utime / h->ticks_per_sec, (double) c->churn_stime / h->ticks_per_sec,
+			       (long) c->churn_spawned, (long) c->churn_exited, (long) c->churn_rss_released);
+		if (h->flags & RING_FLAG_SOCKETS)
+			printf(" %5ld %5ld %5ld %5ld %5ld %5ld %5ld %5ld %5ld %5ld",
+			       (long) c->sock_total, (long) c->sock_established, (long) c->sock_close_wait,
+			       (long) c->sock_listener, (long) c->sock_rest, (long) c->sock_tcp, (long) c->sock_tcp6,
+			       (long) c->sock_udp, (long) c->sock_udp6, (long) c->sock_unix);
+		printf("\n");
+	}
+}
+
+// Is de schrijver opnieuw gestart?  Een nieuwe cmd-metrics zet een nieuw bestand op de plaats
+// van het oude (andere inode), of, bij een ring die in-place is hergebruikt, begint write_seq
+// weer bij 0 en is dus kleiner dan wat we al gezien hebben.
+static int writer_restarted(ring_t *r, const char *path, uint64_t head) {
+	struct stat st_path, st_ring;
+
+	if (ring_in_write_seq(r) < head)
+		return 1;
+	if (stat(path, &st_path) == -1 || fstat(r->fd, &st_ring) == -1)
+		return 0;           // tijdelijk weg of niet te stat-en, probeer het bij de volgende poll weer
+	return st_path.st_ino != st_ring.st_ino || st_path.st_dev != st_ring.st_dev;
+}
+
+int main(int argc, char **argv) {
+	int follow = 0, option;
+	ring_rec_t *rec;
+	uint64_t n, head;
+	ring_t *r, *r_new;
+
+	while ((option = getopt(argc, argv, "f")) != -1) {
+		switch (option) {
+		case 'f': follow = 1;
+		          break;
+		default:  fprintf(stderr, "syntax: $ ring-read [-f] <ring-file>\n");
+		          exit(EXIT_FAILURE);
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "syntax: $ ring-read [-f] <ring-file>\n");
+		exit(EXIT_FAILURE);
+	}
+	if ((r = ring_in_open(argv[optind])) == NULL) {
+		fprintf(stderr, "ERROR: cannot open ring %s: %d (%s)\n", argv[optind], errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if ((rec = malloc(r->hdr->rec_size)) == NULL) {
+		fprintf(stderr, "ERROR: malloc(%u) failed: %d (%s)\n", r->hdr->rec_size, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	// Begin bij het oudste record dat nog in de ring staat.
+	head = ring_in_write_seq(r);
+	n = head > r->hdr->slot_cnt ? head - r->hdr->slot_cnt : 0;
+	while (1) {
+		switch (ring_in_read(r, n, rec)) {
+		case RING_OK:
+			print_rec(r, rec);
+			n++;
+			break;
+		case RING_OVERRUN:
+			// De schrijver heeft ons ingehaald.  Spring naar het oudste record dat er nog is.
+			head = ring_in_write_seq(r);
+			fprintf(stderr, "WARNING: ring overrun, skipped %lu records\n",
+			        (unsigned long) (head - r->hdr->slot_cnt + 1 - n));
+			n = head - r->hdr->slot_cnt + 1;
+			break;
+		case RING_NOT_YET:
+			if (!follow)
+				goto done;
+			if (writer_restarted(r, argv[optind], head)) {
+				// Het nieuwe bestand kan er (nog) niet zijn of anders gedimensioneerd zijn.
+				if ((r_new = ring_in_open(argv[optind])) != NULL) {
+					fprintf(stderr, "WARNING: ring writer restarted, reopening %s\n", argv[optind]);
+					free(rec);
+					ring_close(r);
+					r = r_new;
+					if ((rec = malloc(r->hdr->rec_size)) == NULL) {
+						fprintf(stderr, "ERROR: malloc(%u) failed: %d (%s)\n", r->hdr->rec_size, errno, strerror(errno));
+						exit(EXIT_FAILURE);
+					}
+					head = ring_in_write_seq(r);
+					n = head > r->hdr->slot_cnt ? head - r->hdr->slot_cnt : 0;
+					break;
+				}
+			} else
+				head = ring_in_write_seq(r);
+			fflush(stdout);
+			usleep(RING_READ_POLL_US);
+			break;
+		}
+	}
+done:
+	free(rec);
+	ring_close(r);
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "self-stats.h"
+
+static const char *phase_name[PHASE_CNT] = { "enum", "sock-build", "sock-gather", "smaps", "accum", "output" };
+
+static inline long long clock_ns(clockid_t clk) {
+	struct timespec ts;
+
+	clock_gettime(clk, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void self_stats_init(self_stats_t *s) {
+	memset(s, 0, sizeof(self_stats_t));
+	s->phase = -1;
+}
+
+void self_stats_begin_interval(self_stats_t *s) {
+	if (!s)
+		return;
+	memset(s->wall_ns, 0, sizeof(s->wall_ns));
+	memset(s->cpu_ns, 0, sizeof(s->cpu_ns));
+	s->phase = -1;
+	s->intervals++;
+}
+
+// Sluit de lopende fase af (als die er is) en start de tijdmeting van de volgende.
+// De klokken worden daarbij maar één keer gelezen.  Een fase kan meerdere keren per
+// interval doorlopen worden (bv. smaps en accum per proces); de tijden worden opgeteld.
+// Met s == NULL (geen -T) wordt er niets gemeten.
+void self_stats_switch(self_stats_t *s, int phase) {
+	long long wall, cpu;
+
+	if (!s)
+		return;
+	wall = clock_ns(CLOCK_MONOTONIC);
+	cpu  = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+	if (s->phase >= 0) {
+		s->wall_ns[s->phase]     += wall - s->wall0_ns;
+		s->cpu_ns[s->phase]      += cpu - s->cpu0_ns;
+		s->wall_sum_ns[s->phase] += wall - s->wall0_ns;
+		s->cpu_sum_ns[s->phase]  += cpu - s->cpu0_ns;
+	}
+	s->phase    = phase;
+	s->wall0_ns = wall;
+	s->cpu0_ns  = cpu;
+}
+
+void self_stats_end(self_stats_t *s) {
+	self_stats_switch(s, -1);
+}
+
+// Eén regel per interval: per fase doorlooptijd/CPU-tijd in us, het totaal, en het
+// gemiddelde totaal sinds de start.
+void self_stats_print(FILE *fp, self_stats_t *s) {
+	long long wall = 0, cpu = 0, wall_sum = 0, cpu_sum = 0;
+	int i;
+
+	fprintf(fp, "phases (wall/cpu us):");
+	for (i=0; i<PHASE_CNT; i++) {
+		fprintf(fp, " %s %lld/%lld,", phase_name[i], s->wall_ns[i] / 1000, s->cpu_ns[i] / 1000);
+		wall     += s->wall_ns[i];
+		cpu      += s->cpu_ns[i];
+		wall_sum += s->wall_sum_ns[i];
+		cpu_sum  += s->cpu_sum_ns[i];
+	}
+	fprintf(fp, " total %lld/%lld, avg %lld/%lld\n", wall / 1000, cpu / 1000,
+	        s->intervals ? wall_sum / 1000 / (long long)s->intervals : 0,
+	        s->intervals ? cpu_sum / 1000 / (long long)s->intervals : 0);
+}
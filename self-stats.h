@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Zelf-instrumentatie van de collector (optie -T).
+//
+// Per interval wordt van elke fase van de meting de doorlooptijd (CLOCK_MONOTONIC) en de
+// verbruikte CPU-tijd (CLOCK_PROCESS_CPUTIME_ID, dus inclusief de worker-threads van -j)
+// bijgehouden, zodat op een drukke machine te zien is wat de collector zelf kost en in welke
+// fase, en bv. de -s en -M intervallen op meetgegevens gekozen kunnen worden.
+// Een fase die in een interval niet doorlopen wordt (bv. de socket-scan zonder -s) telt 0.
+
+#define PHASE_ENUM        0            // enumeratie van de processen (libproc2 of /proc/PID/stat met -D)
+#define PHASE_SOCK_BUILD  1            // sock_ino_build_hash_table()
+#define PHASE_SOCK_GATHER 2            // sock_ino_gather_cmd_stats()
+#define PHASE_SMAPS       3            // lezen van smaps_rollup (-M)
+#define PHASE_ACCUM       4            // optellen van de metrics per commando
+#define PHASE_OUTPUT      5            // formatteren en wegschrijven (stdout, -m, -P)
+#define PHASE_CNT         6
+
+struct self_stats {
+	int phase;                         // lopende fase, -1 = geen
+	long long wall0_ns;                // begin van de lopende fase
+	long long cpu0_ns;
+	long long wall_ns[PHASE_CNT];      // dit interval
+	long long cpu_ns[PHASE_CNT];
+	long long wall_sum_ns[PHASE_CNT];  // sinds de start
+	long long cpu_sum_ns[PHASE_CNT];
+	unsigned long intervals;
+};
+
+typedef struct self_stats self_stats_t;
+
+void self_stats_init(self_stats_t *s);
+void self_stats_begin_interval(self_stats_t *s);
+void self_stats_switch(self_stats_t *s, int phase);
+void self_stats_end(self_stats_t *s);
+void self_stats_print(FILE *fp, self_stats_t *s);
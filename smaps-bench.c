@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark voor het lezen van /proc/PID/smaps_rollup (optie -M).
+ *
+ * Start een aantal geforkte processen die een anoniem geheugengebied delen (copy-on-write,
+ * zoals de workers van nginx), en meet per proces de kosten van het lezen van
+ * /proc/PID/stat (wat libproc2 elk interval toch al doet), smaps_rollup en de volledige smaps.
+ * Daarnaast worden de som van de RSS en de som van de PSS afgedrukt, om te laten zien
+ * hoeveel de RSS door het delen van pagina's overschat.
+ *
+ * Gebruik: ./smaps-bench [aantal processen] [MiB per proces] [ronden]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "smaps-stats.h"
+
+#define BENCH_PROCS  50
+#define BENCH_MIB    64
+#define BENCH_ROUNDS 20
+
+static double elapsed(struct timespec *t0, struct timespec *t1) {
+	return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+// Lees een bestand helemaal, zoals libproc2 (stat) of een naïeve smaps-lezer dat doen.
+static long read_file(int pid, const char *name) {
+	static char buf[65536];
+	char path[64];
+	long total = 0;
+	ssize_t n;
+	int fd;
+
+	snprintf(path, sizeof(path), "/proc/%d/%s", pid, name);
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return -1;
+	while ((n = read(fd, buf, sizeof(buf))) > 0)
+		total += n;
+	close(fd);
+	return total;
+}
+
+int main(int argc, char **argv) {
+	int procs  = argc > 1 ? atoi(argv[1]) : BENCH_PROCS;
+	long mib   = argc > 2 ? atol(argv[2]) : BENCH_MIB;
+	int rounds = argc > 3 ? atoi(argv[3]) : BENCH_ROUNDS;
+	struct timespec t0, t1;
+	mem_detail_t m, sum;
+	smaps_t *s;
+	pid_t *pid;
+	char *mem;
+	long rss_sum = 0;
+	int i, r;
+
+	if (procs <= 0 || mib < 0 || rounds <= 0) {
+		fprintf(stderr, "usage: %s [processes] [MiB per process] [rounds]\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if ((pid = calloc(procs, sizeof(pid_t))) == NULL) {
+		printf("ERROR - calloc failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	// Het geheugen wordt vóór de fork beschreven en daarna gedeeld door alle processen.
+	if (mib > 0) {
+		if ((mem = mmap(NULL, mib << 20, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+			printf("ERROR - mmap failed, %d - %s\n", errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		memset(mem, 1, mib << 20);
+	}
+	for (i=0; i<procs; i++) {
+		if ((pid[i] = fork()) == 0) {
+			pause();
+			_exit(0);
+		}
+		if (pid[i] == -1) {
+			printf("ERROR - fork failed, %d - %s\n", errno, strerror(errno));
+			procs = i;
+			break;
+		}
+	}
+
+	s = smaps_create();
+	printf("processes: %d, shared memory: %ld MiB, rounds: %d\n", procs, mib, rounds);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r=0; r<rounds; r++)
+		for (i=0; i<procs; i++)
+			read_file(pid[i], "stat");
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("stat          %8.1f us/process\n", elapsed(&t0, &t1) / rounds / procs * 1e6);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r=0; r<rounds; r++) {
+		memset(&sum, 0, sizeof(sum));
+		for (i=0; i<procs; i++) {
+			if (smaps_read(s, pid[i], &m) == 0)
+				mem_detail_add(&sum, &m);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("smaps_rollup  %8.1f us/process\n", elapsed(&t0, &t1) / rounds / procs * 1e6);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r=0; r<rounds; r++)
+		for (i=0; i<procs; i++)
+			read_file(pid[i], "smaps");
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("smaps         %8.1f us/process\n", elapsed(&t0, &t1) / rounds / procs * 1e6);
+
+	for (i=0; i<procs; i++) {
+		char path[64];
+		FILE *f;
+		long pages;
+
+		snprintf(path, sizeof(path), "/proc/%d/statm", pid[i]);
+		if ((f = fopen(path, "r")) != NULL) {
+			if (fscanf(f, "%*s %ld", &pages) == 1)
+				rss_sum += pages * (sysconf(_SC_PAGESIZE) / 1024);
+			fclose(f);
+		}
+	}
+	printf("sum rss: %ld KiB, sum pss: %ld KiB, sum uss: %ld KiB (%ld processes read, %lu failed)\n",
+	       rss_sum, sum.pss, sum.uss, sum.procs, s->fail_cnt);
+
+	for (i=0; i<procs; i++)
+		kill(pid[i], SIGTERM);
+	while (wait(NULL) > 0)
+		;
+	smaps_destroy(s);
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "smaps-stats.h"
+
+smaps_t * smaps_create(void) {
+	const char *root = getenv("PROC_ROOT") ? : "/proc/";
+	smaps_t *s;
+
+	if ((s = calloc(1, sizeof(smaps_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(smaps_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	if ((s->proc_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		printf("ERROR - failed to open %s, %d - %s\n", root, errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return s;
+}
+
+void smaps_destroy(smaps_t *s) {
+	close(s->proc_fd);
+	free(s);
+}
+
+void mem_detail_add(mem_detail_t *dst, const mem_detail_t *src) {
+	dst->pss       += src->pss;
+	dst->uss       += src->uss;
+	dst->anon      += src->anon;
+	dst->anon_huge += src->anon_huge;
+	dst->swap      += src->swap;
+	dst->procs     += src->procs;
+}
+
+// Vergelijk de sleutel van een regel (tot de ':') met een vaste naam.
+#define KEY_IS(p, n, name) ((n) == sizeof(name) - 1 && memcmp((p), (name), sizeof(name) - 1) == 0)
+
+// Lees /proc/PID/smaps_rollup.  Geeft 0 terug en vult m, of -1 als het proces niet
+// (meer) gelezen kan worden.
+int smaps_read(smaps_t *s, int pid, mem_detail_t *m) {
+	char path[32];
+	char *p, *end, *colon;
+	long val;
+	ssize_t len;
+	size_t n;
+	int fd;
+
+	memset(m, 0, sizeof(mem_detail_t));
+	snprintf(path, sizeof(path), "%d/smaps_rollup", pid);
+	if ((fd = openat(s->proc_fd, path, O_RDONLY | O_CLOEXEC)) == -1) {
+		s->fail_cnt++;
+		return -1;
+	}
+	len = read(fd, s->buf, sizeof(s->buf) - 1);
+	close(fd);
+	// Een kernelthread of een zombie heeft een lege smaps_rollup.
+	if (len <= 0) {
+		s->fail_cnt++;
+		return -1;
+	}
+	s->buf[len] = '\0';
+	s->read_cnt++;
+
+	// De eerste regel is de "[rollup]"-kop, daarna "Naam:   <getal> kB".
+	end = s->buf + len;
+	for (p=memchr(s->buf, '\n', len); p && p < end; p=memchr(p, '\n', end - p)) {
+		p++;
+		if ((colon = memchr(p, ':', end - p)) == NULL)
+			break;
+		n = colon - p;
+		for (val=0, colon++; *colon == ' '; colon++)
+			;
+		for (; *colon >= '0' && *colon <= '9'; colon++)
+			val = val * 10 + (*colon - '0');
+
+		if (KEY_IS(p, n, "Pss"))
+			m->pss = val;
+		else if (KEY_IS(p, n, "Private_Clean") || KEY_IS(p, n, "Private_Dirty"))
+			m->uss += val;
+		else if (KEY_IS(p, n, "Anonymous"))
+			m->anon = val;
+		else if (KEY_IS(p, n, "AnonHugePages"))
+			m->anon_huge = val;
+		else if (KEY_IS(p, n, "SwapPss"))
+			m->swap = val;
+		p = colon;
+	}
+	m->procs = 1;
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define SMAPS_BUF_SIZE 4096            // /proc/PID/smaps_rollup is ongeveer 700 bytes
+
+// Geheugengebruik uit /proc/PID/smaps_rollup (optie -M), in KiB.
+//
+// De RSS van processen die pagina's delen (geforkte workers, gedeelde libraries) telt
+// dezelfde pagina's meerdere keren.  PSS verdeelt elke gedeelde pagina over de processen
+// die hem delen, en USS telt alleen de pagina's die van één proces alleen zijn; de som
+// van de PSS is dus wat een groep processen werkelijk gebruikt.
+//
+// smaps_rollup is veel goedkoper dan smaps (één regel per veld in plaats van per mapping),
+// maar de kernel loopt er nog steeds alle page tables van het proces voor af.  Daarom wordt
+// het in een lagere cadans gelezen dan de rest (zie -M).  Het lezen vereist dezelfde rechten
+// als ptrace (PTRACE_MODE_READ); processen die niet gelezen kunnen worden worden overgeslagen
+// en geteld in fail_cnt.
+typedef struct mem_detail {
+	long pss;                          // Pss
+	long uss;                          // Private_Clean + Private_Dirty
+	long anon;                         // Anonymous
+	long anon_huge;                    // AnonHugePages (transparent huge pages)
+	long swap;                         // SwapPss: het aandeel van het proces in de swap
+	long procs;                        // aantal processen waarvan smaps_rollup gelezen is
+} mem_detail_t;
+
+struct smaps {
+	int proc_fd;                       // open directory /proc/ (voor openat())
+	unsigned long read_cnt;            // aantal gelezen smaps_rollup-files sinds de start
+	unsigned long fail_cnt;            // aantal niet leesbare (gestopt, of geen rechten)
+	char buf[SMAPS_BUF_SIZE];
+};
+
+typedef struct smaps smaps_t;
+
+smaps_t * smaps_create(void);
+void smaps_destroy(smaps_t *s);
+int  smaps_read(smaps_t *s, int pid, mem_detail_t *m);
+void mem_detail_add(mem_detail_t *dst, const mem_detail_t *src);
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark voor de socket-metrics (optie -s) op een synthetische /proc-boom.
+ *
+ * Zet PROC_ROOT en PROC_TCP (enz.) naar een boom die met proc-fixture aangemaakt is en meet
+ * de doorvoer van sock_ino_build_hash_table() (regels van net/tcp per seconde) en van
+ * sock_ino_gather_cmd_stats() (fd's per seconde), over een aantal ronden.  De eerste ronde
+ * groeit de hash-table vanaf de minimale grootte, de volgende ronden zijn gedimensioneerd
+ * op de vorige, zoals van interval tot interval.  De mediaan van de warme ronden is het
+ * getal om te vergelijken tussen twee versies ("make bench" doet dat op meerdere schalen).
+ *
+ * Daarnaast wordt per bestand onder <dir>/net/ de streaming parser van inode-stats.c
+ * vergeleken met de oorspronkelijke (het hele bestand in één buffer, strtok() en sscanf()):
+ * de doorvoer in regels per seconde, en of beide precies dezelfde hash-table opleveren.
+ * Met <dir> = /proc worden de echte bestanden van het systeem gebruikt.
+ *
+ * Gebruik: ./sock-bench <dir> [ronden] [threads]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mempool.h"
+#include "cmd-match.h"
+#include "inode-stats.h"
+
+#define BENCH_ROUNDS 5
+
+static double elapsed(struct timespec *t0, struct timespec *t1) {
+	return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static void bench_setenv(const char *name, const char *dir, const char *file) {
+	char path[4096];
+
+	snprintf(path, sizeof(path), "%s%s", dir, file);
+	setenv(name, path, 1);
+}
+
+// De oorspronkelijke parser, als referentie.
+static int ref_read_proc_file(char *fname, char **buf, long *size) {
+	FILE *fd;
+	char *newptr;
+	long read;
+
+	if (*buf == NULL) {
+		if ((*buf = malloc(*size + 1)) == NULL) {
+			printf("ERROR - malloc(%ld) failed, %d - %s\n", *size, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+	while (1) {
+		if ((fd = fopen(fname, "r")) == NULL)
+			return -1;
+		read = fread(*buf, sizeof(char), *size, fd);
+		memset(*buf + read, 0, 1);
+		if (feof(fd)) {
+			fclose(fd);
+			return 0;
+		}
+		// De data paste niet in de buffer: maak de buffer 2x zo groot en probeer opnieuw.
+		fclose(fd);
+		*size *= 2;
+		if ((newptr = realloc(*buf, *size + 1)) == NULL) {
+			printf("ERROR - realloc(%ld) failed, %d - %s\n", *size + 1, errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		*buf = newptr;
+	}
+}
+
+static long ref_build_from_proc(sock_ino_tab_t *tab, POOL *pool_ino, char **read_buf, long *buflen,
+                                char *net, unsigned int family) {
+	unsigned int addr_loc, port_loc, addr_rem, port_rem, state, uid, ino, flags, type;
+	long lines = 0;
+
+	if (ref_read_proc_file(net, read_buf, buflen) == -1)
+		return -1;
+	char * line = strtok(*read_buf, "\n");
+	line  = strtok(NULL, "\n");       // Skip de eerste regel (=kopregel).
+	while(line) {
+		ino = 0;
+		addr_loc = addr_rem = port_loc = port_rem = 0;
+		switch (family) {
+		case SOCK_FAM_TCP:
+		case SOCK_FAM_UDP:
+			sscanf(line, " %*s %8x:%4x %8x:%4x %2x %*8x:%*8x %*2x:%*8x %*8x %u %*d %u ",
+				&addr_loc, (unsigned int *) &port_loc,
+				&addr_rem, (unsigned int *) &port_rem,
+				&state, &uid, &ino);
+			break;
+		case SOCK_FAM_TCP6:
+		case SOCK_FAM_UDP6:
+			sscanf(line, " %*s %*32[0-9A-Fa-f]:%4x %*32[0-9A-Fa-f]:%4x %2x %*8x:%*8x %*2x:%*8x %*8x %u %*d %u ",
+				(unsigned int *) &port_loc, (unsigned int *) &port_rem,
+				&state, &uid, &ino);
+			break;
+		case SOCK_FAM_UNIX:
+			uid = 0;
+			sscanf(line, "%*s %*x %*x %x %x %x %u", &flags, &type, &state, &ino);
+			break;
+		}
+		if (ino) {
+			sock_ino_add(tab, pool_ino, ino, uid, addr_loc, port_loc, addr_rem, port_rem, state, family);
+		}
+		lines++;
+		line  = strtok(NULL, "\n");
+	}
+	return lines;
+}
+
+// Vergelijk per bestand de oorspronkelijke en de streaming parser.
+static void bench_parse(const char *dir) {
+	static const struct {
+		const char   *name;
+		unsigned int  family;
+	} files[] = {
+		{"tcp", SOCK_FAM_TCP}, {"tcp6", SOCK_FAM_TCP6}, {"udp", SOCK_FAM_UDP},
+		{"udp6", SOCK_FAM_UDP6}, {"unix", SOCK_FAM_UNIX},
+	};
+	sock_ino_tab_t *ref_tab = sock_ino_tab_create(), *tab = sock_ino_tab_create();
+	POOL *ref_pool = pool_create(1024*1024), *pool = pool_create(1024*1024);
+	char *ref_buf = NULL, *buf = NULL;
+	long ref_buflen = INITIAL_READBUF_SIZE, buflen = INITIAL_READBUF_SIZE;
+	struct timespec t0, t1, t2;
+	sock_ino_ent_t *p;
+	unsigned long diff;
+	char path[4096+16];
+	long lines;
+
+	for (int i=0; i<sizeof(files)/sizeof(files[0]); i++) {
+		snprintf(path, sizeof(path), "%snet/%s", dir, files[i].name);
+		// De buffers beginnen elke keer op de oorspronkelijke grootte, zoals bij de start.
+		ref_buflen = buflen = INITIAL_READBUF_SIZE;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		lines = ref_build_from_proc(ref_tab, ref_pool, &ref_buf, &ref_buflen, path, files[i].family);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (lines == -1 || sock_ino_build_from_proc(tab, pool, &buf, &buflen, path, files[i].family) == -1) {
+			printf("parse %-5s not available\n", files[i].name);
+			continue;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		diff = ref_tab->used != tab->used;
+		for (unsigned long k=0; k<ref_tab->size; k++) {
+			if (ref_tab->slots[k].ino == 0)
+				continue;
+			p = sock_ino_find(tab, ref_tab->slots[k].ino);
+			if (!p || memcmp(p, ref_tab->slots[k].ent, sizeof(sock_ino_ent_t)) != 0)
+				diff++;
+		}
+		printf("parse %-5s %8ld lines  sscanf: %8.2f Mlines/s  streaming: %8.2f Mlines/s  %s\n",
+		       files[i].name, lines, lines / elapsed(&t0, &t1) / 1e6, lines / elapsed(&t1, &t2) / 1e6,
+		       diff ? "DIFFERENT" : "identical");
+		sock_ino_destroy_hash_table(ref_tab, ref_pool);
+		sock_ino_destroy_hash_table(tab, pool);
+	}
+	free(ref_buf);
+	free(buf);
+	sock_ino_tab_destroy(ref_tab);
+	sock_ino_tab_destroy(tab);
+	pool_destroy(ref_pool);
+	pool_destroy(pool);
+}
+
+static int cmp_double(const void *a, const void *b) {
+	double x = *(const double *) a, y = *(const double *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv) {
+	int rounds  = argc > 2 ? atoi(argv[2]) : BENCH_ROUNDS;
+	int threads = argc > 3 ? atoi(argv[3]) : 1;
+	sock_ino_tab_t *tab = sock_ino_tab_create();
+	cmd_matcher_t *matcher = cmd_matcher_create();
+	POOL *pool_ino = pool_create(1024*1024);
+	char *read_buf = NULL;
+	long buflen = INITIAL_READBUF_SIZE;
+	sock_scan_stats_t stats;
+	sock_aggr_t s[1];
+	struct timespec t0, t1, t2;
+	double *build, *gather;
+	unsigned long hashed = 0;
+	int m;
+	char dir[4096];
+
+	if (argc < 2 || rounds <= 0 || threads <= 0) {
+		fprintf(stderr, "usage: %s <dir> [rounds] [threads]\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	build  = malloc(rounds * sizeof(double));
+	gather = malloc(rounds * sizeof(double));
+	if (!build || !gather) {
+		printf("ERROR - malloc failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	snprintf(dir, sizeof(dir), "%s/", argv[1]);
+	setenv("PROC_ROOT", dir, 1);
+	bench_setenv("PROC_TCP",  dir, "net/tcp");
+	bench_setenv("PROC_TCP6", dir, "net/tcp6");
+	bench_setenv("PROC_UDP",  dir, "net/udp");
+	bench_setenv("PROC_UDP6", dir, "net/udp6");
+	bench_setenv("PROC_UNIX", dir, "net/unix");
+	cmd_matcher_add_cmd(matcher, "fixture");
+
+	for (int r=0; r<rounds; r++) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		sock_ino_build_hash_table(tab, pool_ino, &read_buf, &buflen);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		sock_ino_gather_cmd_stats(tab, matcher, threads, s, &stats);
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+		hashed = tab->used;
+		sock_ino_destroy_hash_table(tab, pool_ino);
+		build[r]  = elapsed(&t0, &t1);
+		gather[r] = elapsed(&t1, &t2);
+		printf("round %2d %-6s build: %9.2f ms  gather: %9.2f ms\n", r, r == 0 ? "(cold)" : "(warm)",
+		       build[r] * 1000, gather[r] * 1000);
+	}
+
+	// De mediaan van de warme ronden (of de enige ronde).
+	m = 0;
+	if (rounds > 1) {
+		qsort(build + 1, rounds - 1, sizeof(double), cmp_double);
+		qsort(gather + 1, rounds - 1, sizeof(double), cmp_double);
+		m = 1 + (rounds - 1) / 2;
+	}
+	printf("%s: %lu sockets hashed, %lu pids, %lu fds, %lu sockets found, threads: %d\n", argv[1], hashed,
+	       stats.pids_matched, stats.fds_scanned, stats.sockets_found, threads);
+	printf("build:  %9.2f ms  %8.2f Mlines/s\n", build[m] * 1000, hashed / build[m] / 1e6);
+	printf("gather: %9.2f ms  %8.2f Mfds/s\n", gather[m] * 1000, stats.fds_scanned / gather[m] / 1e6);
+	printf("pool-ino: size: %zu, high-water: %zu, extends: %lu\n",
+	       pool_size(pool_ino), pool_high_water(pool_ino), pool_extend_count(pool_ino));
+	bench_parse(dir);
+
+	free(build);
+	free(gather);
+	free(read_buf);
+	sock_ino_tab_destroy(tab);
+	pool_destroy(pool_ino);
+	cmd_matcher_destroy(matcher);
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include "tick-loop.h"
+
+static long long monotonic_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void tick_loop_epoll_add(tick_loop_t *l, int fd) {
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events  = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(l->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		printf("ERROR - epoll_ctl(ADD) failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+// Maak de timer aan en start hem; de eerste tick valt één interval na nu.  Moet
+// aangeroepen worden voordat er threads gestart worden, want de signal-mask wordt geërfd.
+tick_loop_t * tick_loop_create(double interval) {
+	struct itimerspec its;
+	sigset_t mask;
+	tick_loop_t *l;
+	long long start;
+
+	if ((l = calloc(1, sizeof(tick_loop_t))) == NULL) {
+		printf("ERROR - calloc(%ld) failed, %d - %s\n", sizeof(tick_loop_t), errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	l->interval_ns = (long long)(interval * 1e9 + 0.5);
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGHUP);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1 ||
+	    (l->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) == -1 ||
+	    (l->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1 ||
+	    (l->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		printf("ERROR - failed to set up the interval timer, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	start = monotonic_ns();
+	l->sched_ns = start;
+	its.it_value.tv_sec     = (start + l->interval_ns) / 1000000000LL;
+	its.it_value.tv_nsec    = (start + l->interval_ns) % 1000000000LL;
+	its.it_interval.tv_sec  = l->interval_ns / 1000000000LL;
+	its.it_interval.tv_nsec = l->interval_ns % 1000000000LL;
+	if (timerfd_settime(l->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+		printf("ERROR - timerfd_settime failed, %d - %s\n", errno, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	tick_loop_epoll_add(l, l->timer_fd);
+	tick_loop_epoll_add(l, l->signal_fd);
+	return l;
+}
+
+void tick_loop_destroy(tick_loop_t *l) {
+	close(l->epoll_fd);
+	close(l->timer_fd);
+	close(l->signal_fd);
+	free(l);
+}
+
+void tick_loop_add_fd(tick_loop_t *l, int fd) {
+	tick_loop_epoll_add(l, fd);
+}
+
+// Wacht op de volgende gebeurtenis.  Een tick heeft voorrang op de rest, zodat een
+// drukke extra fd de metingen niet kan ophouden.  Geeft een TICK_EV_* terug.
+int tick_loop_wait(tick_loop_t *l, int timeout_ms, int *signo) {
+	struct epoll_event ev[4];
+	struct signalfd_siginfo si;
+	uint64_t exp;
+	int i, n, result = TICK_EV_TIMEOUT;
+
+	while ((n = epoll_wait(l->epoll_fd, ev, 4, timeout_ms)) == -1) {
+		if (errno != EINTR) {
+			printf("ERROR - epoll_wait failed, %d - %s\n", errno, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (i=0; i<n; i++) {
+		if (ev[i].data.fd == l->timer_fd) {
+			if (read(l->timer_fd, &exp, sizeof(exp)) != sizeof(exp))
+				continue;
+			// exp is het aantal verstreken intervallen sinds de vorige read; alles boven de 1 is gemist.
+			l->sched_ns   += exp * l->interval_ns;
+			l->late_ns     = monotonic_ns() - l->sched_ns;
+			l->missed_last = exp - 1;
+			l->missed     += exp - 1;
+			l->ticks++;
+			l->late_sum_ns += l->late_ns;
+			if (l->late_ns > l->late_max_ns)
+				l->late_max_ns = l->late_ns;
+			return TICK_EV_TICK;
+		}
+	}
+	for (i=0; i<n; i++) {
+		if (ev[i].data.fd == l->signal_fd) {
+			if (read(l->signal_fd, &si, sizeof(si)) != sizeof(si))
+				continue;
+			*signo = si.ssi_signo;
+			return TICK_EV_SIGNAL;
+		}
+	}
+	if (n > 0)
+		result = TICK_EV_FD;
+	return result;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 Toon van der Pas, Houten.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Het wachten tussen twee metingen (optie -i).
+//
+// De interval-timer is een timerfd op CLOCK_MONOTONIC met absolute expiratietijden
+// (start + k * interval), zodat de metingen niet verlopen door de tijd die een meting zelf
+// kost, en er ook intervallen kleiner dan een seconde mogelijk zijn.  Duurt een meting
+// langer dan een interval, dan geeft de timerfd het aantal verstreken intervallen terug;
+// de overgeslagen intervallen worden geteld (missed), in plaats van stilzwijgend te
+// verdwijnen zoals bij setitimer() en pause().  Per tick wordt ook bijgehouden hoe laat
+// de meting begint ten opzichte van de planning (late).
+//
+// SIGTERM, SIGINT en SIGHUP worden geblokkeerd en via een signalfd ontvangen; samen met
+// de timerfd en eventuele andere fd's (het metrics-endpoint) zitten ze in één epoll-set.
+
+#define TICK_EV_TICK     1             // het volgende interval is aangebroken
+#define TICK_EV_SIGNAL   2             // er is een signal ontvangen (zie signo)
+#define TICK_EV_FD       3             // een extra fd (tick_loop_add_fd()) is gereed
+#define TICK_EV_TIMEOUT  4             // timeout_ms verstreken zonder gebeurtenis
+
+struct tick_loop {
+	int epoll_fd;
+	int timer_fd;
+	int signal_fd;
+	long long interval_ns;
+	long long sched_ns;                // geplande tijd van de laatste tick (CLOCK_MONOTONIC)
+	unsigned long ticks;               // aantal ticks sinds de start
+	unsigned long missed;              // aantal overgeslagen intervallen sinds de start
+	unsigned long missed_last;         // overgeslagen intervallen bij de laatste tick
+	long long late_ns;                 // vertraging van de laatste tick t.o.v. de planning
+	long long late_max_ns;
+	double late_sum_ns;                // voor het gemiddelde
+};
+
+typedef struct tick_loop tick_loop_t;
+
+tick_loop_t * tick_loop_create(double interval);
+void tick_loop_destroy(tick_loop_t *l);
+void tick_loop_add_fd(tick_loop_t *l, int fd);
+int  tick_loop_wait(tick_loop_t *l, int timeout_ms, int *signo);